@@ -0,0 +1,30 @@
+// BenchArgs.h
+// Numeric command-line arguments shared by the benches. Every value is range-checked, so
+// a typo or a negative count stops the bench with its usage line instead of wrapping to a
+// huge uint32_t or dividing by zero.
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// `text` as an integer in [minValue, maxValue]; anything else prints the problem and
+// `usage` to stderr and exits
+inline uint32_t parseBenchArg(const char* text, const char* name, uint32_t minValue, uint32_t maxValue,
+                              const char* usage) {
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > maxValue) {
+        std::fprintf(stderr, "Invalid %s: %s (expected %u..%u)\n%s\n", name, text, minValue, maxValue, usage);
+        std::exit(1);
+    }
+    return static_cast<uint32_t>(parsed);
+}
+
+// Positional argument `index` (argv[index]) checked as above, or `fallback` when absent
+inline uint32_t benchArg(int argc, char** argv, int index, const char* name, uint32_t fallback,
+                         uint32_t minValue, uint32_t maxValue, const char* usage) {
+    return index < argc ? parseBenchArg(argv[index], name, minValue, maxValue, usage) : fallback;
+}
@@ -0,0 +1,76 @@
+// BenchHarness.h
+// Setup and frame timing shared by the benches that render headless through GraphicsModule
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "GraphicsModule.h"
+#include "GeomCreate.h"
+
+struct FrameTimes {
+    double avgMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+};
+
+class BenchHarness {
+public:
+    // Unmeasured frames before each measurement, so buffers and caches reach steady state
+    static constexpr uint32_t WarmupFrames = 20;
+    // Upper bounds for the benches' count arguments
+    static constexpr uint32_t MaxFrames = 1000000;
+    static constexpr uint32_t MaxDrones = 10000000;
+    static constexpr uint32_t MaxSubdivisions = GeomCreate::MaxIcosphereSubdivisions;
+
+    // Headless 1280x720 renderer drawing an icosphere, with the camera zoomed out by `zoom`.
+    // Returns the mesh's triangle count.
+    static size_t init(GraphicsModule& graphics, uint32_t subdivisions, float zoom) {
+        graphics.setHeadless(1280, 720);
+        graphics.init();
+        graphics.camera.zoom(zoom);
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        GeomCreate::createIcosphere(subdivisions, vertices, indices);
+        graphics.setSphereMesh(GeomCreate::createMesh(graphics.getDevice(), graphics.getAllocator(),
+                                                      graphics.getUploader(), vertices, indices));
+        return indices.size() / 3;
+    }
+
+    // Runs WarmupFrames + frames calls of frame(index, measured) and times the measured
+    // ones. With frames in flight the steady-state loop time is max(CPU, GPU) per frame.
+    template <typename FrameFn>
+    static FrameTimes timeFrames(uint32_t frames, FrameFn&& frame) {
+        using Clock = std::chrono::steady_clock;
+        std::vector<double> frameMs;
+        frameMs.reserve(frames);
+        for (uint32_t f = 0; f < WarmupFrames + frames; ++f) {
+            bool measured = f >= WarmupFrames;
+            auto start = Clock::now();
+            frame(f, measured);
+            if (measured)
+                frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return summarize(std::move(frameMs));
+    }
+
+    // Same nearest-rank percentiles as HeadlessBenchmark's report
+    static FrameTimes summarize(std::vector<double> frameMs) {
+        FrameTimes times;
+        if (frameMs.empty())
+            return times;
+        std::sort(frameMs.begin(), frameMs.end());
+        auto at = [&](double q) {
+            size_t index = static_cast<size_t>(q * (frameMs.size() - 1) + 0.5);
+            return frameMs[std::min(index, frameMs.size() - 1)];
+        };
+        double sum = 0.0;
+        for (double ms : frameMs) sum += ms;
+        times.avgMs = sum / frameMs.size();
+        times.p50Ms = at(0.50);
+        times.p95Ms = at(0.95);
+        return times;
+    }
+};
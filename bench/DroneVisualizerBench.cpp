@@ -0,0 +1,427 @@
+// DroneVisualizerBench.cpp
+// Microbenchmarks for the geometry path, runnable on headless machines (no SDL):
+//   1. GeomCreate sphere generators across the UI's parameter ranges and well beyond
+//      (rows marked * are outside what the UI exposes)
+//   2. MeshOptimizer: time and post-transform cache statistics before/after
+//   3. Float32 vs Packed vertex formats: size, packing cost and quantization error
+//   4. createBuffer and mesh uploads (vertex formats and index widths side by side) through
+//      UploadManager on a Vulkan device, preferring a software (CPU) implementation such
+//      as lavapipe
+// Reports throughput and both heap and device-memory allocation counts.
+// Usage: DroneVisualizerBench [--repeats N] [--skip-vulkan] [--hardware]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchArgs.h"
+#include "GeomCreate.h"
+#include "GpuAllocator.h"
+#include "MeshOptimizer.h"
+#include "UploadManager.h"
+#include "VulkanHelperMethods.h"
+
+// === Heap allocation counting ===
+static std::atomic<uint64_t> heapAllocations{ 0 };
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Fn>
+double bestOf(int repeats, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = Clock::now();
+        fn();
+        best = std::min(best, msSince(start));
+    }
+    return best;
+}
+
+// === Generators ===
+struct GeneratorCase {
+    std::string name;
+    bool beyondUi;
+    std::function<void(std::vector<Vertex>&, std::vector<uint32_t>&)> generate;
+};
+
+void benchGenerators(int repeats) {
+    std::vector<GeneratorCase> cases;
+    cases.push_back({ "lowpoly", false, [](auto& v, auto& i) { GeomCreate::createLowPolySphere(v, i); } });
+    for (uint32_t div : { 3u, 16u, 32u, 64u, 128u, 256u, 512u, 1024u })
+        cases.push_back({ "uv " + std::to_string(div) + "x" + std::to_string(div), div > 64,
+                          [div](auto& v, auto& i) { GeomCreate::createUVSphere(div, div, v, i); } });
+    for (uint32_t subdiv = 0; subdiv <= 8; ++subdiv)
+        cases.push_back({ "ico " + std::to_string(subdiv), subdiv > 5,
+                          [subdiv](auto& v, auto& i) { GeomCreate::createIcosphere(subdiv, v, i); } });
+
+    std::printf("== Generators (best of %d) ==\n", repeats);
+    std::printf("%-14s %10s %10s %10s %12s %10s %10s\n",
+                "mesh", "vertices", "triangles", "ms", "Mvert/s", "MB/s", "heap allocs");
+    for (const auto& c : cases) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        double ms = bestOf(repeats, [&] {
+            std::vector<Vertex> v;
+            std::vector<uint32_t> i;
+            c.generate(v, i);
+            vertices.swap(v);
+            indices.swap(i);
+        });
+
+        // Allocation count of a single call into empty output vectors
+        std::vector<Vertex> v;
+        std::vector<uint32_t> i;
+        uint64_t before = heapAllocations.load();
+        c.generate(v, i);
+        uint64_t allocs = heapAllocations.load() - before;
+
+        double bytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+        double seconds = std::max(ms, 1e-6) / 1000.0;
+        std::printf("%-13s%c %10zu %10zu %10.3f %12.2f %10.1f %10llu\n",
+                    c.name.c_str(), c.beyondUi ? '*' : ' ', vertices.size(), indices.size() / 3, ms,
+                    vertices.size() / seconds / 1e6, bytes / seconds / (1024.0 * 1024.0),
+                    static_cast<unsigned long long>(allocs));
+    }
+}
+
+// === Mesh optimizer ===
+void benchMeshOptimizer(int repeats) {
+    std::printf("\n== Mesh optimizer (vertex cache + vertex fetch, cache size %u, best of %d) ==\n",
+                MeshOptimizer::DefaultCacheSize, repeats);
+    std::printf("%-14s %10s %10s %16s %16s\n", "mesh", "triangles", "ms", "ACMR", "ATVR");
+
+    struct OptimizerCase { std::string name; std::function<void(std::vector<Vertex>&, std::vector<uint32_t>&)> generate; };
+    std::vector<OptimizerCase> cases;
+    for (uint32_t div : { 16u, 64u, 256u, 1024u })
+        cases.push_back({ "uv " + std::to_string(div) + "x" + std::to_string(div),
+                          [div](auto& v, auto& i) { GeomCreate::createUVSphere(div, div, v, i); } });
+    for (uint32_t subdiv : { 3u, 5u, 7u })
+        cases.push_back({ "ico " + std::to_string(subdiv),
+                          [subdiv](auto& v, auto& i) { GeomCreate::createIcosphere(subdiv, v, i); } });
+
+    for (const auto& c : cases) {
+        std::vector<Vertex> sourceVertices;
+        std::vector<uint32_t> sourceIndices;
+        c.generate(sourceVertices, sourceIndices);
+
+        // MeshOptimizerStats::ms excludes the input copies and the statistics
+        MeshOptimizerStats stats;
+        double bestMs = 1e30;
+        for (int r = 0; r < repeats; ++r) {
+            std::vector<Vertex> vertices = sourceVertices;
+            std::vector<uint32_t> indices = sourceIndices;
+            stats = MeshOptimizer::optimize(vertices, indices);
+            bestMs = std::min(bestMs, stats.ms);
+        }
+        std::printf("%-14s %10zu %10.3f %7.3f -> %5.3f %7.3f -> %5.3f\n", c.name.c_str(),
+                    sourceIndices.size() / 3, bestMs, stats.before.acmr, stats.after.acmr,
+                    stats.before.atvr, stats.after.atvr);
+    }
+}
+
+// === Vertex formats ===
+float fromSnorm16(int16_t v) {
+    return std::max(static_cast<float>(v) / 32767.0f, -1.0f);
+}
+
+void benchVertexFormats(int repeats) {
+    std::printf("\n== Vertex formats (Float32 %zu B vs Packed %zu B per vertex, best of %d) ==\n",
+                sizeof(Vertex), sizeof(PackedVertex), repeats);
+    std::printf("%-14s %12s %12s %8s %10s %14s %14s\n",
+                "mesh", "float KB", "packed KB", "ratio", "pack ms", "max pos err", "max normal deg");
+
+    struct FormatCase { const char* name; std::vector<Vertex> vertices; std::vector<uint32_t> indices; };
+    std::vector<FormatCase> cases(3);
+    cases[0].name = "uv 256x256";
+    GeomCreate::createUVSphere(256, 256, cases[0].vertices, cases[0].indices);
+    cases[1].name = "ico 5";
+    GeomCreate::createIcosphere(5, cases[1].vertices, cases[1].indices);
+    cases[2].name = "ico 7";
+    GeomCreate::createIcosphere(7, cases[2].vertices, cases[2].indices);
+
+    for (const auto& c : cases) {
+        std::vector<PackedVertex> packed;
+        float scale = 1.0f;
+        double ms = bestOf(repeats, [&] { scale = GeomCreate::packVertices(c.vertices, packed); });
+
+        float maxPosError = 0.0f, maxNormalDeg = 0.0f;
+        for (size_t i = 0; i < c.vertices.size(); ++i) {
+            const PackedVertex& p = packed[i];
+            glm::vec3 position = glm::vec3(fromSnorm16(p.position[0]), fromSnorm16(p.position[1]),
+                                           fromSnorm16(p.position[2])) * scale;
+            // Same decode as the shaders, so the error columns reflect what the GPU sees
+            glm::vec3 normal = GeomCreate::octDecode(glm::vec2(fromSnorm16(p.normal[0]), fromSnorm16(p.normal[1])));
+            maxPosError = std::max(maxPosError, glm::length(position - c.vertices[i].position));
+            float cosAngle = std::clamp(glm::dot(normal, glm::normalize(c.vertices[i].normal)), -1.0f, 1.0f);
+            maxNormalDeg = std::max(maxNormalDeg, glm::degrees(std::acos(cosAngle)));
+        }
+
+        double floatKB = c.vertices.size() * sizeof(Vertex) / 1024.0;
+        double packedKB = packed.size() * sizeof(PackedVertex) / 1024.0;
+        std::printf("%-14s %12.0f %12.0f %7.2fx %10.3f %14.2e %14.4f\n", c.name, floatKB, packedKB,
+                    floatKB / packedKB, ms, maxPosError, maxNormalDeg);
+    }
+}
+
+// === Vulkan context without a window ===
+struct VulkanContext {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t graphicsFamily = 0, transferFamily = 0;
+    VkQueue graphicsQueue = VK_NULL_HANDLE, transferQueue = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties props{};
+
+    bool init(bool preferHardware) {
+        VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+        appInfo.pApplicationName = "DroneVisualizerBench";
+        appInfo.apiVersion = VK_API_VERSION_1_3;
+        VkInstanceCreateInfo instInfo{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+        instInfo.pApplicationInfo = &appInfo;
+        if (vkCreateInstance(&instInfo, nullptr, &instance) != VK_SUCCESS)
+            return false;
+
+        uint32_t count = 0;
+        vkEnumeratePhysicalDevices(instance, &count, nullptr);
+        std::vector<VkPhysicalDevice> devices(count);
+        vkEnumeratePhysicalDevices(instance, &count, devices.data());
+        for (VkPhysicalDevice candidate : devices) {
+            VkPhysicalDeviceProperties candidateProps;
+            vkGetPhysicalDeviceProperties(candidate, &candidateProps);
+            bool software = candidateProps.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+            if (physicalDevice == VK_NULL_HANDLE || software != preferHardware) {
+                physicalDevice = candidate;
+                props = candidateProps;
+                if (software != preferHardware)
+                    break;
+            }
+        }
+        if (physicalDevice == VK_NULL_HANDLE)
+            return false;
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+        graphicsFamily = UINT32_MAX;
+        for (uint32_t i = 0; i < familyCount && graphicsFamily == UINT32_MAX; ++i)
+            if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                graphicsFamily = i;
+        if (graphicsFamily == UINT32_MAX)
+            return false;
+        transferFamily = graphicsFamily;
+        for (uint32_t i = 0; i < familyCount; ++i) {
+            VkQueueFlags flags = families[i].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                transferFamily = i;
+                break;
+            }
+        }
+
+        float priority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfos[2]{};
+        for (auto& queueInfo : queueInfos) {
+            queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueInfo.queueCount = 1;
+            queueInfo.pQueuePriorities = &priority;
+        }
+        queueInfos[0].queueFamilyIndex = graphicsFamily;
+        queueInfos[1].queueFamilyIndex = transferFamily;
+
+        // UploadManager tracks batches with timeline semaphores and records its
+        // ownership-transfer barriers with synchronization2
+        VkPhysicalDeviceVulkan13Features supported13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+        VkPhysicalDeviceVulkan12Features supported12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        supported12.pNext = &supported13;
+        VkPhysicalDeviceFeatures2 supported{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        supported.pNext = &supported12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+        if (supported12.timelineSemaphore != VK_TRUE || supported13.synchronization2 != VK_TRUE)
+            return false;
+
+        VkPhysicalDeviceVulkan12Features features12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        features12.timelineSemaphore = VK_TRUE;
+        VkPhysicalDeviceVulkan13Features features13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+        features13.synchronization2 = VK_TRUE;
+        features12.pNext = &features13;
+
+        VkDeviceCreateInfo devInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+        devInfo.pNext = &features12;
+        devInfo.queueCreateInfoCount = transferFamily != graphicsFamily ? 2 : 1;
+        devInfo.pQueueCreateInfos = queueInfos;
+        if (vkCreateDevice(physicalDevice, &devInfo, nullptr, &device) != VK_SUCCESS)
+            return false;
+        vkGetDeviceQueue(device, graphicsFamily, 0, &graphicsQueue);
+        vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
+        return true;
+    }
+
+    void cleanup() {
+        if (device != VK_NULL_HANDLE)
+            vkDestroyDevice(device, nullptr);
+        if (instance != VK_NULL_HANDLE)
+            vkDestroyInstance(instance, nullptr);
+    }
+};
+
+// === createBuffer ===
+void benchCreateBuffer(VulkanContext& vk, GpuAllocator& allocator) {
+    std::printf("\n== createBuffer (DEVICE_LOCAL vertex/index buffers, create + destroy) ==\n");
+    std::printf("%-10s %8s %12s %12s %12s %14s\n",
+                "size", "buffers", "create us", "destroy us", "buffers/s", "vkAllocMemory");
+
+    const VkDeviceSize sizes[] = { 4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20 };
+    for (VkDeviceSize size : sizes) {
+        uint32_t count = static_cast<uint32_t>(std::clamp<VkDeviceSize>((256ull << 20) / size, 8, 1024));
+        std::vector<VkBuffer> buffers(count);
+        std::vector<GpuAllocation> allocations(count);
+        uint64_t allocateCallsBefore = allocator.getStats().deviceAllocateCalls;
+
+        auto createStart = Clock::now();
+        for (uint32_t i = 0; i < count; ++i)
+            createBuffer(vk.device, allocator, size,
+                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers[i], allocations[i]);
+        double createMs = msSince(createStart);
+
+        auto destroyStart = Clock::now();
+        for (uint32_t i = 0; i < count; ++i)
+            destroyBuffer(vk.device, allocator, buffers[i], allocations[i]);
+        double destroyMs = msSince(destroyStart);
+
+        uint64_t allocateCalls = allocator.getStats().deviceAllocateCalls - allocateCallsBefore;
+        std::printf("%7llu KB %8u %12.2f %12.2f %12.0f %14llu\n",
+                    static_cast<unsigned long long>(size >> 10), count,
+                    createMs * 1000.0 / count, destroyMs * 1000.0 / count,
+                    count / std::max(createMs / 1000.0, 1e-9),
+                    static_cast<unsigned long long>(allocateCalls));
+    }
+}
+
+// === Mesh uploads ===
+void benchUploads(VulkanContext& vk, GpuAllocator& allocator, UploadManager& uploader, int repeats) {
+    std::printf("\n== Mesh upload (createMesh + transfer until the ticket completes, best of %d) ==\n", repeats);
+    std::printf("%-14s %-8s %6s %10s %10s %10s %10s %14s\n",
+                "mesh", "format", "index", "KB", "ms", "MB/s", "Mvert/s", "vkAllocMemory");
+
+    struct UploadCase {
+        const char* name;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint16_t> indices16;  // empty unless the vertex count fits
+    };
+    std::vector<UploadCase> cases(5);
+    cases[0].name = "uv 64x64";
+    GeomCreate::createUVSphere(64, 64, cases[0].vertices, cases[0].indices);
+    cases[1].name = "uv 256x256";
+    GeomCreate::createUVSphere(256, 256, cases[1].vertices, cases[1].indices);
+    cases[2].name = "ico 5";
+    GeomCreate::createIcosphere(5, cases[2].vertices, cases[2].indices);
+    cases[3].name = "ico 7";
+    GeomCreate::createIcosphere(7, cases[3].vertices, cases[3].indices);
+    cases[4].name = "uv 1024x1024";
+    GeomCreate::createUVSphere(1024, 1024, cases[4].vertices, cases[4].indices);
+
+    for (auto& c : cases) {
+        if (GeomCreate::fitsUint16(c.vertices.size()))
+            c.indices16.assign(c.indices.begin(), c.indices.end());
+    }
+
+    auto run = [&](const UploadCase& c, VertexFormat format, const auto& indices) {
+        uint64_t allocateCallsBefore = allocator.getStats().deviceAllocateCalls;
+        double ms = bestOf(repeats, [&] {
+            GpuMesh mesh = GeomCreate::createMesh(vk.device, allocator, uploader, c.vertices, indices, format);
+            uploader.flush();
+            while (!uploader.isComplete(mesh.uploadTicket))
+                std::this_thread::yield();
+            GeomCreate::destroyMesh(vk.device, allocator, mesh);
+        });
+        uint64_t allocateCalls = allocator.getStats().deviceAllocateCalls - allocateCallsBefore;
+
+        // Packed timings include packVertices
+        double bytes = c.vertices.size() * GeomCreate::vertexStride(format) + indices.size() * sizeof(indices[0]);
+        double seconds = std::max(ms, 1e-6) / 1000.0;
+        std::printf("%-14s %-8s %6s %10.0f %10.3f %10.1f %10.2f %14llu\n", c.name,
+                    format == VertexFormat::Packed ? "packed" : "float", sizeof(indices[0]) == 2 ? "u16" : "u32",
+                    bytes / 1024.0, ms, bytes / seconds / (1024.0 * 1024.0), c.vertices.size() / seconds / 1e6,
+                    static_cast<unsigned long long>(allocateCalls));
+    };
+    for (const auto& c : cases) {
+        for (VertexFormat format : { VertexFormat::Float32, VertexFormat::Packed }) {
+            run(c, format, c.indices);
+            if (!c.indices16.empty())
+                run(c, format, c.indices16);
+        }
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    const char* usage = "Usage: DroneVisualizerBench [--repeats N] [--skip-vulkan] [--hardware]";
+    int repeats = 5;
+    bool skipVulkan = false;
+    bool preferHardware = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = static_cast<int>(parseBenchArg(argv[++i], "repeats", 1, 1000, usage));
+        } else if (std::strcmp(argv[i], "--skip-vulkan") == 0) {
+            skipVulkan = true;
+        } else if (std::strcmp(argv[i], "--hardware") == 0) {
+            preferHardware = true;
+        } else {
+            std::fprintf(stderr, "%s\n", usage);
+            return 1;
+        }
+    }
+
+    benchGenerators(repeats);
+    benchMeshOptimizer(repeats);
+    benchVertexFormats(repeats);
+    if (skipVulkan)
+        return 0;
+
+    VulkanContext vk;
+    if (!vk.init(preferHardware)) {
+        std::fprintf(stderr, "\nNo usable Vulkan device; buffer benchmarks skipped\n");
+        vk.cleanup();
+        return 1;
+    }
+    std::printf("\nDevice: %s (%s)\n", vk.props.deviceName,
+                vk.props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? "software" : "hardware");
+
+    GpuAllocator allocator;
+    UploadManager uploader;
+    allocator.init(vk.device, vk.physicalDevice);
+    uploader.init(vk.device, allocator, vk.graphicsFamily, vk.graphicsQueue, vk.transferFamily, vk.transferQueue);
+
+    benchCreateBuffer(vk, allocator);
+    benchUploads(vk, allocator, uploader, repeats);
+
+    vkDeviceWaitIdle(vk.device);
+    uploader.cleanup();
+    allocator.cleanup();
+    vk.cleanup();
+    return 0;
+}
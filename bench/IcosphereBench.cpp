@@ -0,0 +1,150 @@
+// IcosphereBench.cpp
+// Compares GeomCreate::createIcosphere against the previous single-threaded
+// std::map-based implementation. Usage: IcosphereBench [maxSubdivisions] [repeats]
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BenchArgs.h"
+#include "GeomCreate.h"
+
+namespace legacy {
+uint32_t addVertex(glm::vec3 v, std::vector<Vertex>& verts) {
+    verts.push_back({ glm::normalize(v), glm::normalize(v) });
+    return static_cast<uint32_t>(verts.size() - 1);
+}
+
+uint32_t getMidpoint(uint32_t a, uint32_t b, std::vector<Vertex>& verts,
+                     std::map<std::pair<uint32_t, uint32_t>, uint32_t>& cache) {
+    auto edge = std::minmax(a, b);
+    auto it = cache.find(edge);
+    if (it != cache.end()) return it->second;
+
+    glm::vec3 mid = (verts[a].position + verts[b].position) * 0.5f;
+    uint32_t idx = addVertex(mid, verts);
+    cache[edge] = idx;
+    return idx;
+}
+
+void createIcosphere(uint32_t subdivisions, std::vector<Vertex>& outVertices,
+                     std::vector<uint32_t>& outIndices) {
+    outVertices.clear();
+    outIndices.clear();
+
+    const float X = 0.525731f;
+    const float Z = 0.850651f;
+    const glm::vec3 vdata[] = {
+        {-X, 0, Z}, {X, 0, Z}, {-X, 0, -Z}, {X, 0, -Z},
+        {0, Z, X}, {0, Z, -X}, {0, -Z, X}, {0, -Z, -X},
+        {Z, X, 0}, {-Z, X, 0}, {Z, -X, 0}, {-Z, -X, 0}
+    };
+    const uint32_t tdata[][3] = {
+        {0, 4, 1}, {0, 9, 4}, {9, 5, 4}, {4, 5, 8}, {4, 8, 1},
+        {8, 10, 1}, {8, 3, 10}, {5, 3, 8}, {5, 2, 3}, {2, 7, 3},
+        {7, 10, 3}, {7, 6, 10}, {7, 11, 6}, {11, 0, 6}, {0, 1, 6},
+        {6, 1, 10}, {9, 0, 11}, {9, 11, 2}, {9, 2, 5}, {7, 2, 11}
+    };
+
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpointCache;
+    for (auto& v : vdata)
+        outVertices.push_back({ glm::normalize(v), glm::normalize(v) });
+
+    std::vector<std::array<uint32_t, 3>> faces;
+    for (auto& tri : tdata)
+        faces.push_back({tri[0], tri[1], tri[2]});
+
+    for (uint32_t i = 0; i < subdivisions; ++i) {
+        std::vector<std::array<uint32_t, 3>> newFaces;
+        for (auto& tri : faces) {
+            uint32_t a = getMidpoint(tri[0], tri[1], outVertices, midpointCache);
+            uint32_t b = getMidpoint(tri[1], tri[2], outVertices, midpointCache);
+            uint32_t c = getMidpoint(tri[2], tri[0], outVertices, midpointCache);
+
+            newFaces.push_back({tri[0], a, c});
+            newFaces.push_back({tri[1], b, a});
+            newFaces.push_back({tri[2], c, b});
+            newFaces.push_back({a, b, c});
+        }
+        faces = std::move(newFaces);
+    }
+
+    for (auto& tri : faces) {
+        outIndices.push_back(tri[0]);
+        outIndices.push_back(tri[1]);
+        outIndices.push_back(tri[2]);
+    }
+}
+}
+
+template <typename Fn>
+double bestOf(int repeats, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// Both generators must describe the same surface: same counts, unit-length vertices,
+// valid indices and the same set of positions. Vertices may be numbered differently, but
+// the index buffers must match element by element once resolved to positions, so
+// triangle order, child order and winding are unchanged.
+bool validate(const std::vector<Vertex>& v, const std::vector<uint32_t>& i,
+              const std::vector<Vertex>& refV, const std::vector<uint32_t>& refI) {
+    if (v.size() != refV.size() || i.size() != refI.size())
+        return false;
+    for (const auto& vert : v)
+        if (std::fabs(glm::length(vert.position) - 1.0f) > 1e-4f)
+            return false;
+    for (uint32_t idx : i)
+        if (idx >= v.size())
+            return false;
+
+    auto quantize = [](const glm::vec3& p) {
+        return std::array<long, 3>{ std::lround(p.x * 1e4f), std::lround(p.y * 1e4f), std::lround(p.z * 1e4f) };
+    };
+    std::map<std::array<long, 3>, int> positions;
+    for (const auto& vert : refV) positions[quantize(vert.position)]++;
+    for (const auto& vert : v) {
+        auto it = positions.find(quantize(vert.position));
+        if (it == positions.end() || it->second == 0)
+            return false;
+        it->second--;
+    }
+
+    for (size_t k = 0; k < i.size(); ++k)
+        if (quantize(v[i[k]].position) != quantize(refV[refI[k]].position))
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* usage = "Usage: IcosphereBench [maxSubdivisions] [repeats]";
+    uint32_t maxSubdivisions = benchArg(argc, argv, 1, "maxSubdivisions", 8, 0, 9, usage);
+    int repeats = static_cast<int>(benchArg(argc, argv, 2, "repeats", 3, 1, 1000, usage));
+
+    std::printf("%-6s %12s %12s %12s %10s %8s\n", "subdiv", "vertices", "triangles", "legacy ms", "new ms", "speedup");
+
+    bool ok = true;
+    for (uint32_t n = 0; n <= maxSubdivisions; ++n) {
+        std::vector<Vertex> refV, newV;
+        std::vector<uint32_t> refI, newI;
+
+        double legacyMs = bestOf(repeats, [&] { legacy::createIcosphere(n, refV, refI); });
+        double newMs = bestOf(repeats, [&] { GeomCreate::createIcosphere(n, newV, newI); });
+
+        bool valid = validate(newV, newI, refV, refI);
+        ok = ok && valid;
+
+        std::printf("%-6u %12zu %12zu %12.3f %10.3f %7.2fx%s\n", n, newV.size(), newI.size() / 3,
+                    legacyMs, newMs, legacyMs / std::max(newMs, 1e-6), valid ? "" : "  MISMATCH");
+    }
+    return ok ? 0 : 1;
+}
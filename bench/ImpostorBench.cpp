@@ -0,0 +1,45 @@
+// ImpostorBench.cpp
+// Headless throughput of ray-cast impostors against instanced meshes at 10k, 100k and 1M
+// drones. Every count is drawn three ways, all with GPU culling:
+//   mesh      every visible drone is an icosphere mesh
+//   mixed     drones beyond the camera's orbit distance are impostors
+//   impostor  every visible drone is an impostor
+// Usage: ImpostorBench [frames] [icosphereSubdivisions]
+#include <cstdio>
+#include "BenchArgs.h"
+#include "BenchHarness.h"
+#include "DroneFleet.h"
+
+int main(int argc, char** argv) {
+    const char* usage = "Usage: ImpostorBench [frames] [icosphereSubdivisions]";
+    uint32_t frames = benchArg(argc, argv, 1, "frames", 100, 1, BenchHarness::MaxFrames, usage);
+    uint32_t subdivisions = benchArg(argc, argv, 2, "icosphereSubdivisions", 3, 0, BenchHarness::MaxSubdivisions, usage);
+    const uint32_t counts[] = { 10000, 100000, 1000000 };
+
+    GraphicsModule graphics;
+    size_t triangles = BenchHarness::init(graphics, subdivisions, DroneFleet::ViewZoom);
+    graphics.setGpuCulling(true);
+
+    std::printf("Mesh: icosphere %u, %zu triangles; impostor: 2 triangles; %u frames per step\n",
+                subdivisions, triangles, frames);
+    std::printf("%10s %9s %12s %12s %12s %16s\n", "drones", "path", "avg ms", "p50 ms", "p95 ms", "Mdrones/s");
+
+    auto measure = [&](uint32_t count, const char* path, float impostorDistance) {
+        graphics.setImpostorDistance(impostorDistance);
+        FrameTimes times = BenchHarness::timeFrames(frames, [&](uint32_t f, bool) {
+            DroneFleet::layout(graphics.writeInstances(count), count, f / 60.0f);
+            graphics.draw([&](VkCommandBuffer cmd) { graphics.drawSphere(cmd); });
+        });
+        std::printf("%10u %9s %12.3f %12.3f %12.3f %16.2f\n", count, path,
+                    times.avgMs, times.p50Ms, times.p95Ms, count / times.avgMs / 1000.0);
+    };
+
+    for (uint32_t count : counts) {
+        measure(count, "mesh", 0.0f);
+        measure(count, "mixed", DroneFleet::ViewDistance);
+        measure(count, "impostor", 0.001f);
+    }
+
+    graphics.cleanup();
+    return 0;
+}
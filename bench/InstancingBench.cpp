@@ -0,0 +1,47 @@
+// InstancingBench.cpp
+// Headless frame time of the instanced drone path as the instance count grows.
+// Each count is measured with GPU frustum culling off and on.
+// Usage: InstancingBench [frames] [maxInstances]
+#include <chrono>
+#include <cstdio>
+#include "BenchArgs.h"
+#include "BenchHarness.h"
+#include "DroneFleet.h"
+
+int main(int argc, char** argv) {
+    const char* usage = "Usage: InstancingBench [frames] [maxInstances]";
+    uint32_t frames = benchArg(argc, argv, 1, "frames", 200, 1, BenchHarness::MaxFrames, usage);
+    uint32_t maxInstances = benchArg(argc, argv, 2, "maxInstances", 250000, 1, BenchHarness::MaxDrones, usage);
+
+    GraphicsModule graphics;
+    size_t triangles = BenchHarness::init(graphics, 2, DroneFleet::ViewZoom);
+
+    std::printf("Mesh: %zu triangles, %u frames per step\n", triangles, frames);
+    std::printf("%10s %8s %12s %12s %12s %12s\n", "instances", "culling", "avg ms", "p50 ms", "p95 ms", "update ms");
+
+    using Clock = std::chrono::steady_clock;
+    auto measure = [&](uint32_t count, bool culling) {
+        graphics.setGpuCulling(culling);
+        double updateMs = 0.0;
+
+        FrameTimes times = BenchHarness::timeFrames(frames, [&](uint32_t f, bool measured) {
+            auto start = Clock::now();
+            DroneFleet::layout(graphics.writeInstances(count), count, f / 60.0f);
+            if (measured)
+                updateMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            graphics.draw([&](VkCommandBuffer cmd) { graphics.drawSphere(cmd); });
+        });
+
+        std::printf("%10u %8s %12.3f %12.3f %12.3f %12.3f\n", count, culling ? "gpu" : "off",
+                    times.avgMs, times.p50Ms, times.p95Ms, updateMs / frames);
+    };
+
+    for (uint32_t count = 1; count <= maxInstances; count *= 4) {
+        measure(count, false);
+        measure(count, true);
+    }
+
+    graphics.cleanup();
+    return 0;
+}
@@ -0,0 +1,84 @@
+// RecordScalingBench.cpp
+// Headless CPU recording cost of a draw-call-heavy frame against the number of recording
+// threads. The fleet is drawn in small slices, one draw call each, grouped into tasks that
+// record into secondary command buffers (GraphicsModule::drawTasks). "inline" records the
+// same draws straight into the primary on the calling thread, as draw() does; "cached"
+// reuses the tasks' buffers across frames while the scene version holds (RenderTask::cacheVersion),
+// which is the idle-dashboard case: the fleet still animates, but nothing is re-recorded.
+// Record ms is the profiler's Record phase (0 with the profiler compiled out).
+// Usage: RecordScalingBench [frames] [drones] [dronesPerDraw] [tasks]
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchArgs.h"
+#include "BenchHarness.h"
+#include "DroneFleet.h"
+
+int main(int argc, char** argv) {
+    const char* usage = "Usage: RecordScalingBench [frames] [drones] [dronesPerDraw] [tasks]";
+    uint32_t frames = benchArg(argc, argv, 1, "frames", 100, 1, BenchHarness::MaxFrames, usage);
+    uint32_t drones = benchArg(argc, argv, 2, "drones", 100000, 1, BenchHarness::MaxDrones, usage);
+    uint32_t dronesPerDraw = benchArg(argc, argv, 3, "dronesPerDraw", std::min(8u, drones), 1, drones, usage);
+    uint32_t taskCount = benchArg(argc, argv, 4, "tasks", 64, 1, 4096, usage);
+    const uint32_t workerCounts[] = { 0, 1, 2, 3, 4, 6, 8, 12, 16 };
+
+    GraphicsModule graphics;
+    BenchHarness::init(graphics, 1, DroneFleet::ViewZoom);
+    graphics.setGpuCulling(false);
+
+    uint32_t drawCount = (drones + dronesPerDraw - 1) / dronesPerDraw;
+    uint32_t drawsPerTask = (drawCount + taskCount - 1) / taskCount;
+    auto recordDraws = [&](VkCommandBuffer cmd, uint32_t firstDraw, uint32_t lastDraw) {
+        for (uint32_t d = firstDraw; d < std::min(lastDraw, drawCount); ++d)
+            graphics.drawSphereInstances(cmd, d * dronesPerDraw, std::min(dronesPerDraw, drones - d * dronesPerDraw));
+    };
+
+    std::vector<RenderTask> tasks;
+    for (uint32_t t = 0; t < taskCount; ++t) {
+        uint32_t first = t * drawsPerTask;
+        tasks.push_back({ "Batch", [&recordDraws, first, drawsPerTask](VkCommandBuffer cmd) {
+            recordDraws(cmd, first, first + drawsPerTask);
+        } });
+    }
+
+    std::vector<RenderTask> cachedTasks = tasks;
+    for (auto& task : cachedTasks)
+        task.cacheVersion = [&graphics] { return graphics.getSceneVersion(); };
+
+    std::printf("%u drones, %u draws of %u, %u tasks, %u frames per step, %u hardware threads\n",
+                drones, drawCount, dronesPerDraw, taskCount, frames, std::thread::hardware_concurrency());
+    std::printf("%9s %12s %12s %12s %12s\n", "workers", "record ms", "frame ms", "p95 ms", "speedup");
+
+    Profiler& profiler = graphics.getProfiler();
+    double baselineRecordMs = 0.0;
+    auto measure = [&](const char* label, const std::vector<RenderTask>* frameTasks) {
+        double recordSum = 0.0;
+        FrameTimes times = BenchHarness::timeFrames(frames, [&](uint32_t f, bool measured) {
+            DroneFleet::layout(graphics.writeInstances(drones), drones, f / 60.0f);
+            if (frameTasks)
+                graphics.drawTasks(*frameTasks);
+            else
+                graphics.draw([&](VkCommandBuffer cmd) { recordDraws(cmd, 0, drawCount); });
+            if (measured && profiler.getSampleCount() > 0)
+                recordSum += profiler.getSample(profiler.getSampleCount() - 1).cpuMs[static_cast<uint32_t>(CpuPhase::Record)];
+        });
+
+        double recordMs = recordSum / frames;
+        if (baselineRecordMs == 0.0)
+            baselineRecordMs = recordMs;
+        std::printf("%9s %12.3f %12.3f %12.3f %11.2fx\n", label, recordMs, times.avgMs, times.p95Ms,
+                    recordMs > 0.0 ? baselineRecordMs / recordMs : 0.0);
+    };
+
+    measure("inline", nullptr);
+    for (uint32_t workers : workerCounts) {
+        graphics.setRecordThreads(workers);
+        measure(std::to_string(workers).c_str(), &tasks);
+    }
+    measure("cached", &cachedTasks);
+
+    graphics.cleanup();
+    return 0;
+}
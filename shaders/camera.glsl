@@ -0,0 +1,8 @@
+// Camera matrices, written once per frame into the frame slot's uniform buffer
+// (CameraUniforms in HelpStructures.h). Set 1 in every sphere pipeline layout; set 0 holds
+// the instances where a pipeline uses them.
+layout(std140, set = 1, binding = 0) uniform Camera {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+} camera;
@@ -0,0 +1,10 @@
+// Decoding for VertexFormat::Packed (GeomCreate::packVertices). GeomCreate::octDecode is the
+// CPU mirror; change both together.
+
+// Inverse of the octahedral encoding: folds the lower half back over the diagonals
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
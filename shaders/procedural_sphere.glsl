@@ -0,0 +1,76 @@
+// Unit sphere triangles generated from gl_VertexIndex, drawn non-indexed with no vertex
+// input. Included by sphere_procedural*.vert; the including shader declares
+// PushConstants with `uint shape, latDiv, lonDiv, subdivisions` after its matrix.
+//
+// UV spheres reproduce GeomCreate::createUVSphere triangle for triangle. Icospheres split
+// each icosahedron face into a uniform grid before projecting onto the sphere, where
+// GeomCreate bisects and projects level by level, so vertices differ slightly but the
+// triangle count and winding are the same. Either way position == normal.
+
+const uint ShapeUVSphere = 0u;
+const uint ShapeIcosphere = 1u;
+const float Pi = 3.14159265358979;
+
+const float IcoX = 0.525731;
+const float IcoZ = 0.850651;
+const vec3 icoVertices[12] = vec3[12](
+    vec3(-IcoX, 0.0, IcoZ), vec3(IcoX, 0.0, IcoZ), vec3(-IcoX, 0.0, -IcoZ), vec3(IcoX, 0.0, -IcoZ),
+    vec3(0.0, IcoZ, IcoX), vec3(0.0, IcoZ, -IcoX), vec3(0.0, -IcoZ, IcoX), vec3(0.0, -IcoZ, -IcoX),
+    vec3(IcoZ, IcoX, 0.0), vec3(-IcoZ, IcoX, 0.0), vec3(IcoZ, -IcoX, 0.0), vec3(-IcoZ, -IcoX, 0.0));
+const uvec3 icoFaces[20] = uvec3[20](
+    uvec3(0, 4, 1), uvec3(0, 9, 4), uvec3(9, 5, 4), uvec3(4, 5, 8), uvec3(4, 8, 1),
+    uvec3(8, 10, 1), uvec3(8, 3, 10), uvec3(5, 3, 8), uvec3(5, 2, 3), uvec3(2, 7, 3),
+    uvec3(7, 10, 3), uvec3(7, 6, 10), uvec3(7, 11, 6), uvec3(11, 0, 6), uvec3(0, 1, 6),
+    uvec3(6, 1, 10), uvec3(9, 0, 11), uvec3(9, 11, 2), uvec3(9, 2, 5), uvec3(7, 2, 11));
+
+// Six vertices per lat/lon quad: (first, second, first + 1), (second, second + 1, first + 1)
+// as (lat, lon) steps
+const uvec2 uvQuadCorners[6] = uvec2[6](
+    uvec2(0, 0), uvec2(1, 0), uvec2(0, 1), uvec2(1, 0), uvec2(1, 1), uvec2(0, 1));
+
+vec3 uvSphereVertex(uint vertexIndex) {
+    uint quad = vertexIndex / 6u;
+    uvec2 corner = uvQuadCorners[vertexIndex % 6u];
+    uint lat = quad / pc.lonDiv + corner.x;
+    uint lon = quad % pc.lonDiv + corner.y;
+
+    float theta = float(lat) * Pi / float(pc.latDiv);
+    float phi = float(lon) * 2.0 * Pi / float(pc.lonDiv);
+    return vec3(cos(phi) * sin(theta), cos(theta), sin(phi) * sin(theta));
+}
+
+// Face grid with n = 2^subdivisions segments per edge. Row r (from the face's first corner)
+// holds 2r + 1 triangles alternating up and down; point (r, c) lies c steps from edge AB
+// towards edge AC. Both triangle kinds keep the face's winding.
+vec3 icosphereVertex(uint vertexIndex) {
+    uint n = 1u << pc.subdivisions;
+    uint triangle = vertexIndex / 3u;
+    uint corner = vertexIndex % 3u;
+    uint face = triangle / (n * n);
+    uint t = triangle % (n * n);
+
+    uint row = uint(sqrt(float(t)));
+    if (row * row > t)
+        row--;
+    else if ((row + 1u) * (row + 1u) <= t)
+        row++;
+    uint k = t - row * row;
+    uint c = k / 2u;
+
+    uvec2 point;
+    if ((k & 1u) == 0u)
+        point = corner == 0u ? uvec2(row, c) : (corner == 1u ? uvec2(row + 1u, c) : uvec2(row + 1u, c + 1u));
+    else
+        point = corner == 0u ? uvec2(row, c) : (corner == 1u ? uvec2(row + 1u, c + 1u) : uvec2(row, c + 1u));
+
+    uvec3 f = icoFaces[face];
+    vec3 a = icoVertices[f.x];
+    vec3 b = icoVertices[f.y];
+    vec3 cc = icoVertices[f.z];
+    float step = 1.0 / float(n);
+    return normalize(a + (b - a) * (float(point.x - point.y) * step) + (cc - a) * (float(point.y) * step));
+}
+
+vec3 proceduralSphereVertex(uint vertexIndex) {
+    return pc.shape == ShapeUVSphere ? uvSphereVertex(vertexIndex) : icosphereVertex(vertexIndex);
+}
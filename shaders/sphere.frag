@@ -1,18 +1,14 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec3 fragNormal;
 layout(location = 1) in vec3 fragPosition;
+layout(location = 2) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
-const vec3 lightPos = vec3(5.0, 5.0, 5.0);
-const vec3 lightColor = vec3(1.0);
-const vec3 baseColor = vec3(1.0, 0.8, 0.3);
+#include "sphere_lighting.glsl"
 
 void main() {
-    vec3 norm = normalize(fragNormal);
-    vec3 lightDir = normalize(lightPos - fragPosition);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 color = baseColor * diff * lightColor;
-    outColor = vec4(color, 1.0);
+    outColor = vec4(shadeSphere(fragNormal, fragPosition, fragColor), 1.0);
 }
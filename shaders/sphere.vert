@@ -1,18 +1,31 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(push_constant) uniform PushConstants {
-    mat4 mvp;
     mat4 model;
 } pc;
 
+#include "camera.glsl"
+#include "packed_vertex.glsl"
+
+// VertexFormat::Packed: positions arrive as snorm16 (already in [-1, 1]) and inNormal.xy
+// holds an octahedral-encoded unit vector
+layout(constant_id = 0) const bool PackedNormals = false;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 
 layout(location = 0) out vec3 fragNormal;
 layout(location = 1) out vec3 fragPosition;
+layout(location = 2) out vec3 fragColor;
+
+const vec3 baseColor = vec3(1.0, 0.8, 0.3);
 
 void main() {
-    fragNormal = mat3(transpose(inverse(pc.model))) * inNormal;
+    // The packed position scale is folded into pc.model on the CPU
+    vec3 normal = PackedNormals ? octDecode(inNormal.xy) : inNormal;
+    fragNormal = mat3(transpose(inverse(pc.model))) * normal;
     fragPosition = vec3(pc.model * vec4(inPosition, 1.0));
-    gl_Position = pc.mvp * vec4(inPosition, 1.0);
+    fragColor = baseColor;
+    gl_Position = camera.viewProj * vec4(fragPosition, 1.0);
 }
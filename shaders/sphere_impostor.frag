@@ -0,0 +1,35 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Exact sphere per pixel: intersects the view ray through this fragment with the sphere,
+// shades the hit like sphere.frag and writes its depth so impostors and meshes interleave.
+
+#include "camera.glsl"
+
+layout(location = 0) in vec3 viewPosition;
+layout(location = 1) flat in vec3 viewCenter;
+layout(location = 2) flat in float radius;
+layout(location = 3) flat in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+#include "sphere_lighting.glsl"
+
+void main() {
+    // The camera sits at the view-space origin
+    vec3 rayDir = normalize(viewPosition);
+    float b = dot(rayDir, viewCenter);
+    float h = b * b - (dot(viewCenter, viewCenter) - radius * radius);
+    if (h < 0.0)
+        discard;
+    vec3 hit = rayDir * (b - sqrt(h));
+
+    // The view matrix is rigid, so its transposed rotation takes view space back to world
+    mat3 viewToWorld = transpose(mat3(camera.view));
+    vec3 normal = viewToWorld * (hit - viewCenter);
+    vec3 position = viewToWorld * (hit - camera.view[3].xyz);
+
+    vec4 clip = camera.proj * vec4(hit, 1.0);
+    gl_FragDepth = clip.z / clip.w;
+    outColor = vec4(shadeSphere(normal, position, fragColor), 1.0);
+}
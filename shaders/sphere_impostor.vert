@@ -0,0 +1,64 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Ray-cast sphere impostor: each drone becomes a quad facing the camera that covers the
+// sphere's silhouette, and sphere_impostor.frag intersects every pixel's view ray with the
+// sphere. Six vertices per instance, no vertex input.
+
+struct Instance {
+    mat4 model;
+    vec4 color;
+    uint state;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+#include "camera.glsl"
+
+layout(location = 0) out vec3 viewPosition;  // point on the quad, view space
+layout(location = 1) flat out vec3 viewCenter;
+layout(location = 2) flat out float radius;
+layout(location = 3) flat out vec3 fragColor;
+
+const uint StateHidden = 1u;
+const uint StateHighlighted = 2u;
+
+// GeomCreate's spheres have unit radius
+const float SphereRadius = 1.0;
+
+// Two triangles covering the quad. Their winding does not matter: the impostor pipeline
+// is built with culling off.
+const vec2 corners[6] = vec2[6](
+    vec2(-1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, -1.0),
+    vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    Instance inst = instances[gl_InstanceIndex];
+
+    if ((inst.state & StateHidden) != 0u) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0); // outside the clip volume
+        return;
+    }
+
+    float scale = max(length(inst.model[0].xyz), max(length(inst.model[1].xyz), length(inst.model[2].xyz)));
+    viewCenter = (camera.view * vec4(inst.model[3].xyz, 1.0)).xyz;
+    radius = SphereRadius * scale;
+
+    // Quad in the plane through the centre, perpendicular to the view ray. The silhouette
+    // cone crosses that plane in a circle of radius r * d / sqrt(d^2 - r^2).
+    float d = length(viewCenter);
+    vec3 forward = viewCenter / d;
+    vec3 right = abs(forward.y) < 0.999 ? normalize(cross(forward, vec3(0.0, 1.0, 0.0))) : vec3(1.0, 0.0, 0.0);
+    vec3 up = cross(right, forward);
+    float halfSize = radius * d / sqrt(max(d * d - radius * radius, 1e-6));
+
+    vec2 corner = corners[gl_VertexIndex];
+    viewPosition = viewCenter + (right * corner.x + up * corner.y) * halfSize;
+    fragColor = (inst.state & StateHighlighted) != 0u ? vec3(1.0, 0.2, 0.2) : inst.color.rgb;
+    gl_Position = camera.proj * vec4(viewPosition, 1.0);
+}
@@ -0,0 +1,57 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Instanced variant of sphere.vert: per-drone transform, color and state come from a
+// storage buffer indexed by gl_InstanceIndex.
+
+struct Instance {
+    mat4 model;
+    vec4 color;
+    uint state;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform PushConstants {
+    float positionScale;
+} pc;
+
+#include "camera.glsl"
+#include "packed_vertex.glsl"
+
+// VertexFormat::Packed: positions arrive as snorm16 in [-1, 1], hence pc.positionScale, and inNormal.xy
+// holds an octahedral-encoded unit vector
+layout(constant_id = 0) const bool PackedNormals = false;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPosition;
+layout(location = 2) out vec3 fragColor;
+
+const uint StateHidden = 1u;
+const uint StateHighlighted = 2u;
+
+void main() {
+    Instance inst = instances[gl_InstanceIndex];
+
+    if ((inst.state & StateHidden) != 0u) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0); // outside the clip volume
+        return;
+    }
+
+    // Drones are scaled uniformly, so the model matrix transforms normals correctly
+    // up to length; the fragment shader renormalizes
+    vec3 normal = PackedNormals ? octDecode(inNormal.xy) : inNormal;
+    vec4 worldPos = inst.model * vec4(inPosition * pc.positionScale, 1.0);
+    fragNormal = mat3(inst.model) * normal;
+    fragPosition = worldPos.xyz;
+    fragColor = (inst.state & StateHighlighted) != 0u ? vec3(1.0, 0.2, 0.2) : inst.color.rgb;
+    gl_Position = camera.viewProj * worldPos;
+}
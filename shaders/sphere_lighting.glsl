@@ -0,0 +1,12 @@
+// Diffuse point light shared by the mesh and impostor sphere fragment shaders. Inputs are
+// world space; the normal need not be unit length.
+
+const vec3 lightPos = vec3(5.0, 5.0, 5.0);
+const vec3 lightColor = vec3(1.0);
+
+vec3 shadeSphere(vec3 normal, vec3 position, vec3 color) {
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(lightPos - position);
+    float diff = max(dot(norm, lightDir), 0.0);
+    return color * diff * lightColor;
+}
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// sphere.vert without vertex input: the unit sphere comes from gl_VertexIndex
+// (procedural_sphere.glsl). The sphere sits at the origin, so viewProj is also its MVP.
+
+layout(push_constant) uniform PushConstants {
+    uint shape;
+    uint latDiv;
+    uint lonDiv;
+    uint subdivisions;
+} pc;
+
+#include "procedural_sphere.glsl"
+#include "camera.glsl"
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPosition;
+layout(location = 2) out vec3 fragColor;
+
+const vec3 baseColor = vec3(1.0, 0.8, 0.3);
+
+void main() {
+    vec3 position = proceduralSphereVertex(uint(gl_VertexIndex));
+    fragNormal = position;
+    fragPosition = position;
+    fragColor = baseColor;
+    gl_Position = camera.viewProj * vec4(position, 1.0);
+}
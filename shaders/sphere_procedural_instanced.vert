@@ -0,0 +1,51 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// sphere_instanced.vert without vertex input: the unit sphere comes from gl_VertexIndex
+// (procedural_sphere.glsl), the drone from gl_InstanceIndex.
+
+struct Instance {
+    mat4 model;
+    vec4 color;
+    uint state;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform PushConstants {
+    uint shape;
+    uint latDiv;
+    uint lonDiv;
+    uint subdivisions;
+} pc;
+
+#include "procedural_sphere.glsl"
+#include "camera.glsl"
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPosition;
+layout(location = 2) out vec3 fragColor;
+
+const uint StateHidden = 1u;
+const uint StateHighlighted = 2u;
+
+void main() {
+    Instance inst = instances[gl_InstanceIndex];
+
+    if ((inst.state & StateHidden) != 0u) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0); // outside the clip volume
+        return;
+    }
+
+    vec3 position = proceduralSphereVertex(uint(gl_VertexIndex));
+    vec4 worldPos = inst.model * vec4(position, 1.0);
+    fragNormal = mat3(inst.model) * position;
+    fragPosition = worldPos.xyz;
+    fragColor = (inst.state & StateHighlighted) != 0u ? vec3(1.0, 0.2, 0.2) : inst.color.rgb;
+    gl_Position = camera.viewProj * worldPos;
+}
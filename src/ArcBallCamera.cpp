@@ -7,19 +7,23 @@ void ArcBallCamera::rotate(float deltaYaw, float deltaPitch) {
     yaw += deltaYaw;
     pitch += deltaPitch;
     pitch = glm::clamp(pitch, -glm::half_pi<float>() + 0.01f, glm::half_pi<float>() - 0.01f);
+    version++;
 }
 
 void ArcBallCamera::zoom(float delta) {
     distance += delta;
     distance = glm::max(0.1f, distance);
+    version++;
 }
 
 void ArcBallCamera::roll(float delta) {
     rollAngle += delta;
+    version++;
 }
 
 void ArcBallCamera::setViewport(float width, float height) {
     aspect = width / height;
+    version++;
 }
 
 glm::mat4 ArcBallCamera::getViewMatrix() const {
@@ -39,3 +43,23 @@ glm::mat4 ArcBallCamera::getProjectionMatrix() const {
     proj[1][1] *= -1; // for Vulkan
     return proj;
 }
+
+void ArcBallCamera::getFrustumPlanes(glm::vec4 planes[6]) const {
+    // Gribb-Hartmann extraction from the clip matrix rows. glm::perspective produces
+    // -w..w depth, so the near plane is row3 + row2.
+    glm::mat4 m = getProjectionMatrix() * getViewMatrix();
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+
+    for (int i = 0; i < 6; ++i)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+}
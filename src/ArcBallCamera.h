@@ -1,10 +1,13 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
 
 class ArcBallCamera {
 public:
-    ArcBallCamera(glm::vec3 target = glm::vec3(0.0f), float dist = 3.0f);
+    static constexpr float DefaultDistance = 3.0f;
+
+    ArcBallCamera(glm::vec3 target = glm::vec3(0.0f), float dist = DefaultDistance);
 
     void rotate(float deltaYaw, float deltaPitch);
     void zoom(float delta);
@@ -14,6 +17,14 @@ public:
     glm::mat4 getViewMatrix() const;
     glm::mat4 getProjectionMatrix() const;
 
+    // World-space planes (xyz = inward normal, w = distance) in the order
+    // left, right, bottom, top, near, far. A point p is inside when dot(plane.xyz, p) + plane.w >= 0.
+    void getFrustumPlanes(glm::vec4 planes[6]) const;
+
+    // Bumped by every call that changes the view or projection; compare against a saved
+    // value to tell whether anything derived from the matrices is stale
+    uint64_t getVersion() const { return version; }
+
 private:
     glm::vec3 target;
     float distance;
@@ -22,4 +33,5 @@ private:
     float rollAngle;
     float aspect;
     float fov = glm::radians(45.0f);
+    uint64_t version = 1;
 };
@@ -0,0 +1,37 @@
+// DroneFleet.cpp
+#include "DroneFleet.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+void DroneFleet::layout(InstanceData* out, uint32_t count, float timeSeconds,
+                        float droneScale, float extent) {
+    if (count == 0)
+        return;
+
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+    float spacing = std::min(1.0f, extent / static_cast<float>(side));
+    float origin = -0.5f * spacing * static_cast<float>(side - 1);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t row = i / side;
+        uint32_t col = i % side;
+        float phase = static_cast<float>(i) * 0.37f;
+
+        glm::vec3 position(origin + spacing * col,
+                           0.25f * std::sin(timeSeconds * 1.5f + phase),
+                           origin + spacing * row);
+
+        InstanceData& inst = out[i];
+        inst.model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(droneScale));
+
+        // Hue cycles along the grid so neighbouring drones are distinguishable
+        float hue = static_cast<float>(i % 64) / 64.0f;
+        inst.color = glm::vec4(0.5f + 0.5f * std::cos(6.2831853f * hue),
+                               0.5f + 0.5f * std::cos(6.2831853f * (hue + 0.333f)),
+                               0.5f + 0.5f * std::cos(6.2831853f * (hue + 0.667f)),
+                               1.0f);
+        inst.state = (i % 97 == 0) ? InstanceHighlighted : 0u;
+        inst.padding[0] = inst.padding[1] = inst.padding[2] = 0;
+    }
+}
@@ -0,0 +1,20 @@
+// DroneFleet.h
+#pragma once
+
+#include <cstdint>
+#include "ArcBallCamera.h"
+#include "HelpStructures.h"
+
+// Demo fleet layout: drones on a square grid centred on the origin, bobbing over time.
+// Used by the viewer and the benchmarks so both draw the same workload.
+class DroneFleet {
+public:
+    static constexpr float DefaultExtent = 40.0f;
+    // Camera distance from the origin that keeps a default-extent fleet in view
+    static constexpr float ViewDistance = 1.5f * DefaultExtent;
+    // ArcBallCamera::zoom from the default distance to ViewDistance
+    static constexpr float ViewZoom = ViewDistance - ArcBallCamera::DefaultDistance;
+
+    static void layout(InstanceData* out, uint32_t count, float timeSeconds,
+                       float droneScale = 0.15f, float extent = DefaultExtent);
+};
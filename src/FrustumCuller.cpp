@@ -0,0 +1,299 @@
+// FrustumCuller.cpp
+#include "FrustumCuller.h"
+#include "HelpStructures.h"
+#include "VulkanHelperMethods.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+constexpr uint32_t WorkgroupSize = 64;
+constexpr uint32_t BindingCount = 5;
+}
+
+void FrustumCuller::init(VkDevice inDevice, GpuAllocator& inAllocator, uint32_t frameCount,
+                         VkDescriptorSetLayout instanceSetLayout, bool drawIndirectCountSupported,
+                         VkPipelineCache pipelineCache) {
+    device = inDevice;
+    allocator = &inAllocator;
+    indirectCount = drawIndirectCountSupported;
+
+    // 0 instances, 1 visible, 2 indirect, 3 LOD state, 4 previous frame's LOD state
+    VkDescriptorSetLayoutBinding bindings[BindingCount]{};
+    for (uint32_t i = 0; i < BindingCount; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layoutInfo.bindingCount = BindingCount;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &computeSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create culling descriptor set layout");
+
+    // Per frame: one compute set (BindingCount buffers) and one draw set (1 buffer)
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * (BindingCount + 1) };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    poolInfo.maxSets = frameCount * 2;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create culling descriptor pool");
+
+    VkPushConstantRange pushConstant{};
+    pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstant.offset = 0;
+    pushConstant.size = sizeof(CullPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &computeSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create culling pipeline layout");
+
+    VkShaderModule module = loadShaderModule(device, "cull_instances.comp.spv");
+
+    VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+    VkResult result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device, module, nullptr);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to create culling pipeline");
+
+    slots.resize(frameCount);
+    for (auto& slot : slots) {
+        VkDescriptorSetLayout layouts[2] = { computeSetLayout, instanceSetLayout };
+        VkDescriptorSet sets[2];
+        VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 2;
+        allocInfo.pSetLayouts = layouts;
+        if (vkAllocateDescriptorSets(device, &allocInfo, sets) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate culling descriptor sets");
+        slot.computeSet = sets[0];
+        slot.drawSet = sets[1];
+
+        createBuffer(device, *allocator, sizeof(IndirectHeader),
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.indirectBuffer, slot.indirectAllocation);
+    }
+}
+
+void FrustumCuller::cleanup() {
+    for (auto& slot : slots) {
+        destroyBuffer(device, *allocator, slot.visibleBuffer, slot.visibleAllocation);
+        destroyBuffer(device, *allocator, slot.lodStateBuffer, slot.lodStateAllocation);
+        destroyBuffer(device, *allocator, slot.indirectBuffer, slot.indirectAllocation);
+        destroyRetired(slot);
+    }
+    slots.clear();
+
+    if (pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+        pipeline = VK_NULL_HANDLE;
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        pipelineLayout = VK_NULL_HANDLE;
+    }
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        descriptorPool = VK_NULL_HANDLE;
+    }
+    if (computeSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, computeSetLayout, nullptr);
+        computeSetLayout = VK_NULL_HANDLE;
+    }
+}
+
+void FrustumCuller::record(VkCommandBuffer cmd, uint32_t frame, VkBuffer instances, uint32_t instanceCount,
+                           const glm::vec4 planes[6], const GpuMesh& mesh, const LodParams& lod) {
+    // The slot's previous submission has completed (fence waited), so its buffers and
+    // descriptor sets can be rewritten here
+    Slot& slot = slots[frame];
+    destroyRetired(slot);
+    ensureCapacity(frame, instanceCount);
+
+    // Hysteresis input: the level each instance got in the frame recorded just before this
+    // one. That frame may still be running, but it precedes this one on the queue and the
+    // barrier below orders its writes before our reads. With one slot this aliases our own
+    // state, which each invocation reads before it overwrites its own entry.
+    const Slot& previous = slots[(frame + slots.size() - 1) % slots.size()];
+    const uint32_t lodCount = std::max(1u, std::min(mesh.lodCount, MaxMeshLods));
+    bool havePrevious = previous.lodStateBuffer != VK_NULL_HANDLE && previous.lodCount == lodCount;
+    uint32_t previousCount = havePrevious ? std::min(previous.lodStateCount, instanceCount) : 0;
+    // Rewritten every frame: the instance buffer may have been reallocated since the last
+    // use of this slot, possibly under a recycled handle value
+    writeComputeSet(slot, instances, havePrevious ? previous.lodStateBuffer : slot.lodStateBuffer);
+    slot.lodStateCount = instanceCount;
+    slot.lodCount = lodCount;
+
+    // Reset the draws: one per level with its index range, zero instances, zero draws
+    IndirectHeader header{};
+    for (uint32_t level = 0; level < slot.lodCount; ++level) {
+        const MeshLod& meshLod = mesh.lodCount > 0 ? mesh.lods[level] : MeshLod{ 0, mesh.indexCount, 0.0f };
+        header.commands[level].indexCount = meshLod.indexCount;
+        header.commands[level].firstIndex = meshLod.firstIndex;
+        header.switchDistances[level] = lodSwitchDistance(meshLod, lod.pixelsPerUnit, lod.pixelError);
+    }
+    header.impostorCommand.vertexCount = ImpostorVertexCount;
+    header.cameraPosition = glm::vec4(lod.cameraPosition, LodHysteresis);
+    vkCmdUpdateBuffer(cmd, slot.indirectBuffer, 0, sizeof(header), &header);
+
+    VkMemoryBarrier2 resetBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    resetBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    resetBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+    resetBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+    memoryBarrier(cmd, resetBarrier);
+
+    CullPushConstants pc{};
+    for (int i = 0; i < 6; ++i)
+        pc.planes[i] = planes[i];
+    pc.instanceCount = instanceCount;
+    pc.meshRadius = mesh.boundingRadius;
+    pc.lodCount = slot.lodCount;
+    pc.previousInstanceCount = previousCount;
+    pc.impostorDistance = lod.impostorDistance;
+
+    uint32_t groups = (instanceCount + WorkgroupSize - 1) / WorkgroupSize;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &slot.computeSet, 0, nullptr);
+
+    // Pass 0: cull, pick levels and impostors, count per bucket
+    pc.pass = 0;
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pc);
+    vkCmdDispatch(cmd, groups, 1, 1);
+
+    VkMemoryBarrier2 classifyBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    classifyBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    classifyBarrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    classifyBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    classifyBarrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+    memoryBarrier(cmd, classifyBarrier);
+
+    // Pass 1: scatter into per-bucket ranges, fill the draws
+    pc.pass = 1;
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pc);
+    vkCmdDispatch(cmd, groups, 1, 1);
+
+    VkMemoryBarrier2 cullBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    cullBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    cullBarrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    cullBarrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+    cullBarrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+    memoryBarrier(cmd, cullBarrier);
+}
+
+void FrustumCuller::draw(VkCommandBuffer cmd, uint32_t frame, VkPipelineLayout instancedLayout, bool indexed) {
+    Slot& slot = slots[frame];
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedLayout, 0, 1, &slot.drawSet, 0, nullptr);
+
+    // VkDrawIndirectCommand read over the indexed command: vertexCount, instanceCount and
+    // firstVertex line up with indexCount, instanceCount and firstIndex, and firstInstance
+    // lands on vertexOffset, always 0. Level 0 of a one-level chain starts at instance 0 too.
+    if (!indexed) {
+        if (slot.lodCount != 1)
+            throw std::runtime_error("Non-indexed culled draws need a single-level mesh");
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        if (indirectCount)
+            vkCmdDrawIndirectCount(cmd, slot.indirectBuffer, 0, slot.indirectBuffer, DrawCountOffset, 1, stride);
+        else
+            vkCmdDrawIndirect(cmd, slot.indirectBuffer, 0, 1, stride);
+        return;
+    }
+
+    // One draw per level: each has its own index range, so they cannot share a multi-draw
+    // count without also sharing firstIndex
+    const VkDeviceSize stride = sizeof(VkDrawIndexedIndirectCommand);
+    for (uint32_t level = 0; level < slot.lodCount; ++level) {
+        VkDeviceSize offset = offsetof(IndirectHeader, commands) + level * stride;
+        if (indirectCount) {
+            vkCmdDrawIndexedIndirectCount(cmd, slot.indirectBuffer, offset, slot.indirectBuffer,
+                                          DrawCountOffset + level * sizeof(uint32_t), 1, stride);
+        } else {
+            vkCmdDrawIndexedIndirect(cmd, slot.indirectBuffer, offset, 1, stride);
+        }
+    }
+}
+
+void FrustumCuller::drawImpostors(VkCommandBuffer cmd, uint32_t frame, VkPipelineLayout layout) {
+    Slot& slot = slots[frame];
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &slot.drawSet, 0, nullptr);
+
+    if (indirectCount) {
+        vkCmdDrawIndirectCount(cmd, slot.indirectBuffer, ImpostorCommandOffset, slot.indirectBuffer,
+                               ImpostorDrawCountOffset, 1, sizeof(VkDrawIndirectCommand));
+    } else {
+        vkCmdDrawIndirect(cmd, slot.indirectBuffer, ImpostorCommandOffset, 1, sizeof(VkDrawIndirectCommand));
+    }
+}
+
+void FrustumCuller::ensureCapacity(uint32_t frame, uint32_t count) {
+    Slot& slot = slots[frame];
+    if (count <= slot.capacity && slot.visibleBuffer != VK_NULL_HANDLE)
+        return;
+
+    uint32_t capacity = std::max({ count, slot.capacity + slot.capacity / 2, 1024u });
+    destroyBuffer(device, *allocator, slot.visibleBuffer, slot.visibleAllocation);
+    createBuffer(device, *allocator, sizeof(InstanceData) * capacity,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 slot.visibleBuffer, slot.visibleAllocation);
+
+    // The next slot's frame reads this state as its history and may be recorded before this
+    // slot's fence comes around again; hand the old buffer to it to free once it is done
+    if (slot.lodStateBuffer != VK_NULL_HANDLE) {
+        slots[(frame + 1) % slots.size()].retired.push_back({ slot.lodStateBuffer, slot.lodStateAllocation });
+        slot.lodStateBuffer = VK_NULL_HANDLE;
+        slot.lodStateAllocation = {};
+    }
+    createBuffer(device, *allocator, sizeof(uint32_t) * capacity,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 slot.lodStateBuffer, slot.lodStateAllocation);
+    slot.lodStateCount = 0;
+    slot.capacity = capacity;
+
+    VkDescriptorBufferInfo visibleInfo{ slot.visibleBuffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = slot.drawSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &visibleInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    drawSetVersion++;
+}
+
+void FrustumCuller::writeComputeSet(Slot& slot, VkBuffer instances, VkBuffer previousLodState) {
+    VkDescriptorBufferInfo infos[BindingCount] = {
+        { instances, 0, VK_WHOLE_SIZE },
+        { slot.visibleBuffer, 0, VK_WHOLE_SIZE },
+        { slot.indirectBuffer, 0, VK_WHOLE_SIZE },
+        { slot.lodStateBuffer, 0, VK_WHOLE_SIZE },
+        { previousLodState, 0, VK_WHOLE_SIZE },
+    };
+
+    VkWriteDescriptorSet writes[BindingCount]{};
+    for (uint32_t i = 0; i < BindingCount; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = slot.computeSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, BindingCount, writes, 0, nullptr);
+}
+
+void FrustumCuller::destroyRetired(Slot& slot) {
+    for (auto& retired : slot.retired)
+        destroyBuffer(device, *allocator, retired.buffer, retired.allocation);
+    slot.retired.clear();
+}
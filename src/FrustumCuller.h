@@ -0,0 +1,127 @@
+// FrustumCuller.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "GpuAllocator.h"
+#include "Mesh.h"
+
+// GPU frustum culling and LOD selection for instanced draws.
+//
+// record() runs two compute passes (outside any render pass) over the frame's instance
+// buffer. The first culls each instance and picks its level of detail from the projected
+// geometric error (selectMeshLod, with hysteresis against the level it got last frame);
+// the second writes the visible instances to a compacted buffer grouped by level and fills
+// one indirect draw command plus draw count per level. draw() consumes them with
+// vkCmdDrawIndexedIndirectCount (or vkCmdDrawIndexedIndirect when drawIndirectCount is
+// unavailable, where an empty level becomes a zero-instance draw). The compacted buffer is
+// exposed through a descriptor set compatible with InstanceBuffer's layout, so the
+// instanced pipeline is used unchanged. A single-level mesh is simply a chain of one.
+//
+// Instances beyond LodParams::impostorDistance go to an extra bucket after the levels,
+// drawn by drawImpostors() as one non-indexed quad each.
+class FrustumCuller {
+public:
+    void init(VkDevice device, GpuAllocator& allocator, uint32_t frameCount,
+              VkDescriptorSetLayout instanceSetLayout, bool drawIndirectCountSupported,
+              VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    void cleanup();
+
+    struct LodParams {
+        glm::vec3 cameraPosition{ 0.0f };
+        float pixelsPerUnit = 1.0f;  // see lodSwitchDistance
+        float pixelError = 1.0f;
+        float impostorDistance = 0.0f;  // world units from the camera; 0 disables impostors
+    };
+
+    // Vertices of one impostor quad (two triangles) in sphere_impostor.vert
+    static constexpr uint32_t ImpostorVertexCount = 6;
+
+    void record(VkCommandBuffer cmd, uint32_t frame, VkBuffer instances, uint32_t instanceCount,
+                const glm::vec4 planes[6], const GpuMesh& mesh, const LodParams& lod);
+
+    // Inside the render pass, with the instanced pipeline bound. A non-indexed draw (the
+    // procedural sphere) takes the level's index range as its vertex range and needs a
+    // single-level mesh, see draw().
+    void draw(VkCommandBuffer cmd, uint32_t frame, VkPipelineLayout instancedLayout, bool indexed = true);
+    // The impostor bucket, with the impostor pipeline bound; `layout` must have
+    // InstanceBuffer's set layout at set 0
+    void drawImpostors(VkCommandBuffer cmd, uint32_t frame, VkPipelineLayout layout);
+    // Bumped whenever a slot's draw descriptor set is rewritten (the compacted buffer grew),
+    // which invalidates command buffers that recorded draw() or drawImpostors()
+    uint64_t getDrawSetVersion() const { return drawSetVersion; }
+
+private:
+    struct CullPushConstants {
+        glm::vec4 planes[6];
+        uint32_t instanceCount;
+        float meshRadius;
+        uint32_t lodCount;
+        uint32_t previousInstanceCount;  // entries of the previous frame's LOD state that are valid
+        uint32_t pass;                   // 0: cull and classify, 1: scatter
+        float impostorDistance;
+        uint32_t padding[2];
+    };
+
+    // Buckets: one per level, then the impostors
+    static constexpr uint32_t ImpostorBucket = MaxMeshLods;
+    static constexpr uint32_t BucketCount = MaxMeshLods + 1;
+
+    // Mirrors the IndirectDraw block in cull_instances.comp; rewritten every frame
+    struct IndirectHeader {
+        VkDrawIndexedIndirectCommand commands[MaxMeshLods];
+        uint32_t drawCounts[MaxMeshLods];
+        VkDrawIndirectCommand impostorCommand;
+        uint32_t impostorDrawCount;
+        uint32_t bucketCounts[BucketCount];   // visible instances per bucket
+        uint32_t bucketCursors[BucketCount];  // scatter pass allocation
+        uint32_t padding;
+        glm::vec4 cameraPosition;             // w = LodHysteresis
+        float switchDistances[MaxMeshLods];
+    };
+    static_assert(offsetof(IndirectHeader, cameraPosition) == 288, "vec4 must sit on a 16-byte boundary in std430");
+
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+    };
+
+    struct Slot {
+        VkBuffer visibleBuffer = VK_NULL_HANDLE;
+        GpuAllocation visibleAllocation;
+        // Level chosen for every instance last time this slot ran; the next slot reads it
+        VkBuffer lodStateBuffer = VK_NULL_HANDLE;
+        GpuAllocation lodStateAllocation;
+        uint32_t lodStateCount = 0;
+        uint32_t capacity = 0;
+        VkBuffer indirectBuffer = VK_NULL_HANDLE;
+        GpuAllocation indirectAllocation;
+        uint32_t lodCount = 1;
+        VkDescriptorSet computeSet = VK_NULL_HANDLE;
+        VkDescriptorSet drawSet = VK_NULL_HANDLE;
+        // Replaced LOD state buffers the following frame may still read; freed once this
+        // slot's fence has been waited on again
+        std::vector<Buffer> retired;
+    };
+
+    static constexpr VkDeviceSize DrawCountOffset = offsetof(IndirectHeader, drawCounts);
+    static constexpr VkDeviceSize ImpostorCommandOffset = offsetof(IndirectHeader, impostorCommand);
+    static constexpr VkDeviceSize ImpostorDrawCountOffset = offsetof(IndirectHeader, impostorDrawCount);
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    bool indirectCount = false;
+
+    VkDescriptorSetLayout computeSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    std::vector<Slot> slots;
+    uint64_t drawSetVersion = 0;
+
+    void ensureCapacity(uint32_t frame, uint32_t count);
+    void writeComputeSet(Slot& slot, VkBuffer instances, VkBuffer previousLodState);
+    void destroyRetired(Slot& slot);
+};
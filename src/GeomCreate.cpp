@@ -2,24 +2,43 @@
 #include <cmath>
 #include <stdexcept>
 #include <cstring>
-#include <map>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtx/norm.hpp>
 #include "VulkanHelperMethods.h"
 
 // === Vertex Input Descriptions ===
-VkVertexInputBindingDescription GeomCreate::getBindingDescription() {
+VkVertexInputBindingDescription GeomCreate::getBindingDescription(VertexFormat format) {
     VkVertexInputBindingDescription binding{};
     binding.binding = 0;
-    binding.stride = sizeof(Vertex);
+    binding.stride = vertexStride(format);
     binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
     return binding;
 }
 
-std::vector<VkVertexInputAttributeDescription> GeomCreate::getAttributeDescriptions() {
+std::vector<VkVertexInputAttributeDescription> GeomCreate::getAttributeDescriptions(VertexFormat format) {
     std::vector<VkVertexInputAttributeDescription> attrs(2);
+    if (format == VertexFormat::Packed) {
+        // SNORM fetch hands the shader floats in [-1, 1]; the missing normal components
+        // read as 0, and the shader decodes the octahedral pair from .xy
+        attrs[0].binding = 0;
+        attrs[0].location = 0;
+        attrs[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attrs[0].offset = offsetof(PackedVertex, position);
+
+        attrs[1].binding = 0;
+        attrs[1].location = 1;
+        attrs[1].format = VK_FORMAT_R16G16_SNORM;
+        attrs[1].offset = offsetof(PackedVertex, normal);
+        return attrs;
+    }
+
     attrs[0].binding = 0;
     attrs[0].location = 0;
     attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
@@ -33,10 +52,20 @@ std::vector<VkVertexInputAttributeDescription> GeomCreate::getAttributeDescripti
     return attrs;
 }
 
+namespace {
+template <typename IndexT>
+void checkIndexRange(size_t vertexCount) {
+    if (vertexCount > size_t(std::numeric_limits<IndexT>::max()) + 1)
+        throw std::runtime_error("Mesh has too many vertices for its index type");
+}
+}
+
 // === UV Sphere ===
+template <typename IndexT>
 void GeomCreate::createUVSphere(uint32_t latDiv, uint32_t lonDiv,
                                 std::vector<Vertex>& outVertices,
-                                std::vector<uint32_t>& outIndices) {
+                                std::vector<IndexT>& outIndices) {
+    checkIndexRange<IndexT>(uvSphereVertexCount(latDiv, lonDiv));
     outVertices.clear();
     outIndices.clear();
 
@@ -60,20 +89,17 @@ void GeomCreate::createUVSphere(uint32_t latDiv, uint32_t lonDiv,
             uint32_t first = lat * (lonDiv + 1) + lon;
             uint32_t second = first + lonDiv + 1;
 
-            outIndices.push_back(first);
-            outIndices.push_back(second);
-            outIndices.push_back(first + 1);
-
-            outIndices.push_back(second);
-            outIndices.push_back(second + 1);
-            outIndices.push_back(first + 1);
+            outIndices.insert(outIndices.end(), {
+                IndexT(first), IndexT(second), IndexT(first + 1),
+                IndexT(second), IndexT(second + 1), IndexT(first + 1) });
         }
     }
 }
 
 // === Low-Poly Sphere (dodecahedron-like for test) ===
+template <typename IndexT>
 void GeomCreate::createLowPolySphere(std::vector<Vertex>& outVertices,
-                                     std::vector<uint32_t>& outIndices) {
+                                     std::vector<IndexT>& outIndices) {
     std::vector<glm::vec3> positions = {
         { 0.0f,  0.0f,  1.0f}, { 0.894f,  0.0f,  0.447f}, { 0.276f,  0.851f,  0.447f},
         {-0.724f,  0.526f,  0.447f}, {-0.724f, -0.526f,  0.447f}, { 0.276f, -0.851f,  0.447f},
@@ -94,37 +120,108 @@ void GeomCreate::createLowPolySphere(std::vector<Vertex>& outVertices,
     };
 }
 
-// === Icosphere (basic recursive subdivision of icosahedron) ===
+// === Icosphere (recursive subdivision of icosahedron) ===
+//
+// Every level splits each triangle into four. The mesh is closed and consistently wound,
+// so every undirected edge appears exactly twice: once as a->b and once as b->a. The face
+// holding the a<b direction owns the edge and creates its midpoint; a prefix sum over the
+// per-face owned-edge counts gives each owner a fixed slot in the vertex array. Owners
+// publish their midpoints in a lock-free open-addressing table, and the other face looks
+// them up after a join. Each phase runs in parallel over faces and the result is
+// deterministic: level k's vertices are always a prefix of level k+1's.
 namespace {
-glm::vec3 normalize(const glm::vec3& v) {
-    return glm::normalize(v);
-}
+template <typename Fn>
+void parallelFor(size_t count, size_t minPerThread, Fn fn) {
+    size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    size_t threadCount = std::min(hw, count / std::max<size_t>(minPerThread, 1));
+    if (threadCount <= 1) {
+        fn(size_t(0), count);
+        return;
+    }
 
-uint32_t addVertex(glm::vec3 v, std::vector<Vertex>& verts,
-                   std::map<std::pair<uint32_t, uint32_t>, uint32_t>& midpointCache) {
-    verts.push_back({ normalize(v), normalize(v) });
-    return static_cast<uint32_t>(verts.size() - 1);
+    size_t chunk = (count + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+    for (size_t t = 1; t < threadCount; ++t) {
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin < end)
+            workers.emplace_back(fn, begin, end);
+    }
+    fn(size_t(0), std::min(count, chunk));
+    for (auto& worker : workers)
+        worker.join();
 }
 
-uint32_t getMidpoint(uint32_t a, uint32_t b,
-                     std::vector<Vertex>& verts,
-                     std::map<std::pair<uint32_t, uint32_t>, uint32_t>& cache) {
-    auto edge = std::minmax(a, b);
-    auto it = cache.find(edge);
-    if (it != cache.end()) return it->second;
+class EdgeMidpointTable {
+public:
+    static constexpr uint64_t Empty = ~uint64_t(0);
+
+    void reserve(size_t maxEdges) {
+        size_t capacity = capacityFor(maxEdges);
+        keys.reset(new std::atomic<uint64_t>[capacity]);
+        values.reset(new uint32_t[capacity]);
+    }
+
+    // edgeCount must not exceed the reserved maximum
+    void reset(size_t edgeCount) {
+        mask = capacityFor(edgeCount) - 1;
+        parallelFor(mask + 1, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                keys[i].store(Empty, std::memory_order_relaxed);
+        });
+    }
+
+    // Each key is inserted exactly once (by the owning face), so inserts never race on a key
+    void insert(uint64_t key, uint32_t value) {
+        size_t slot = hash(key) & mask;
+        for (;;) {
+            uint64_t expected = Empty;
+            if (keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) {
+                values[slot] = value;
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    // Only valid after all inserts have completed (threads joined)
+    uint32_t find(uint64_t key) const {
+        size_t slot = hash(key) & mask;
+        while (keys[slot].load(std::memory_order_relaxed) != key)
+            slot = (slot + 1) & mask;
+        return values[slot];
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<uint32_t[]> values;
+    size_t mask = 0;
 
-    glm::vec3 mid = (verts[a].position + verts[b].position) * 0.5f;
-    uint32_t idx = addVertex(mid, verts, cache);
-    cache[edge] = idx;
-    return idx;
+    static size_t capacityFor(size_t edgeCount) {
+        size_t capacity = 64;
+        while (capacity < edgeCount * 2) capacity <<= 1; // load factor <= 0.5
+        return capacity;
+    }
+
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
 }
 }
 
+template <typename IndexT>
 void GeomCreate::createIcosphere(uint32_t subdivisions,
                                  std::vector<Vertex>& outVertices,
-                                 std::vector<uint32_t>& outIndices) {
-    outVertices.clear();
-    outIndices.clear();
+                                 std::vector<IndexT>& outIndices) {
+    checkIndexRange<IndexT>(icosphereVertexCount(subdivisions));
 
     const float X = 0.525731f;
     const float Z = 0.850651f;
@@ -141,63 +238,326 @@ void GeomCreate::createIcosphere(uint32_t subdivisions,
         {6, 1, 10}, {9, 0, 11}, {9, 11, 2}, {9, 2, 5}, {7, 2, 11}
     };
 
-    std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpointCache;
-    for (auto& v : vdata)
-        outVertices.push_back({ normalize(v), normalize(v) });
-
-    std::vector<std::array<uint32_t, 3>> faces;
-    for (auto& tri : tdata)
-        faces.push_back({tri[0], tri[1], tri[2]});
-
-    for (uint32_t i = 0; i < subdivisions; ++i) {
-        std::vector<std::array<uint32_t, 3>> newFaces;
-        for (auto& tri : faces) {
-            uint32_t a = getMidpoint(tri[0], tri[1], outVertices, midpointCache);
-            uint32_t b = getMidpoint(tri[1], tri[2], outVertices, midpointCache);
-            uint32_t c = getMidpoint(tri[2], tri[0], outVertices, midpointCache);
-
-            newFaces.push_back({tri[0], a, c});
-            newFaces.push_back({tri[1], b, a});
-            newFaces.push_back({tri[2], c, b});
-            newFaces.push_back({a, b, c});
-        }
-        faces = std::move(newFaces);
+    // Closed form: F = 20 * 4^n, V = 10 * 4^n + 2
+    const size_t finalFaces = size_t(20) << (2 * subdivisions);
+    const size_t finalVertices = icosphereVertexCount(subdivisions);
+
+    outVertices.clear();
+    outVertices.resize(finalVertices);
+    for (size_t i = 0; i < 12; ++i) {
+        glm::vec3 p = glm::normalize(vdata[i]);
+        outVertices[i] = { p, p };
+    }
+
+    // Ping-pong face buffers, arranged so the last level lands in outIndices
+    std::vector<IndexT> scratch;
+    outIndices.clear();
+    outIndices.resize(finalFaces * 3);
+    if (subdivisions > 0)
+        scratch.resize(finalFaces * 3 / 4);
+    std::vector<IndexT>* src = (subdivisions % 2 == 0) ? &outIndices : &scratch;
+    std::vector<IndexT>* dst = (subdivisions % 2 == 0) ? &scratch : &outIndices;
+    for (size_t f = 0; f < 20; ++f)
+        for (size_t k = 0; k < 3; ++k)
+            (*src)[f * 3 + k] = IndexT(tdata[f][k]);
+
+    EdgeMidpointTable midpoints;
+    std::vector<uint32_t> ownedBase;
+    if (subdivisions > 0) {
+        midpoints.reserve(finalFaces * 3 / 8);
+        ownedBase.resize(finalFaces / 4 + 1);
     }
 
-    for (auto& tri : faces) {
-        outIndices.push_back(tri[0]);
-        outIndices.push_back(tri[1]);
-        outIndices.push_back(tri[2]);
+    size_t faceCount = 20;
+    size_t vertexCount = 12;
+    const size_t MinFacesPerThread = 4096;
+
+    for (uint32_t level = 0; level < subdivisions; ++level) {
+        const IndexT* faces = src->data();
+        IndexT* next = dst->data();
+        Vertex* verts = outVertices.data();
+        const uint32_t base = static_cast<uint32_t>(vertexCount);
+
+        // Phase A: count edges owned by each face
+        parallelFor(faceCount, MinFacesPerThread, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f < end; ++f) {
+                const IndexT* t = faces + f * 3;
+                ownedBase[f + 1] = (t[0] < t[1]) + (t[1] < t[2]) + (t[2] < t[0]);
+            }
+        });
+        ownedBase[0] = 0;
+        for (size_t f = 0; f < faceCount; ++f)
+            ownedBase[f + 1] += ownedBase[f];
+
+        midpoints.reset(faceCount * 3 / 2);
+
+        // Phase B: owners create their midpoints in their reserved slots
+        parallelFor(faceCount, MinFacesPerThread, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f < end; ++f) {
+                const IndexT* t = faces + f * 3;
+                uint32_t slot = base + ownedBase[f];
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = t[e], b = t[(e + 1) % 3];
+                    if (a < b) {
+                        glm::vec3 p = glm::normalize(verts[a].position + verts[b].position);
+                        verts[slot] = { p, p };
+                        midpoints.insert(edgeKey(a, b), slot);
+                        ++slot;
+                    }
+                }
+            }
+        });
+
+        // Phase C: emit the four children of every face
+        parallelFor(faceCount, MinFacesPerThread, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f < end; ++f) {
+                const IndexT* t = faces + f * 3;
+                uint32_t slot = base + ownedBase[f];
+                uint32_t mid[3];
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = t[e], b = t[(e + 1) % 3];
+                    mid[e] = (a < b) ? slot++ : midpoints.find(edgeKey(a, b));
+                }
+                // mid[0] = ab, mid[1] = bc, mid[2] = ca (same child order as before)
+                IndexT* out = next + f * 12;
+                out[0] = t[0];           out[1] = IndexT(mid[0]);  out[2] = IndexT(mid[2]);
+                out[3] = t[1];           out[4] = IndexT(mid[1]);  out[5] = IndexT(mid[0]);
+                out[6] = t[2];           out[7] = IndexT(mid[2]);  out[8] = IndexT(mid[1]);
+                out[9] = IndexT(mid[0]); out[10] = IndexT(mid[1]); out[11] = IndexT(mid[2]);
+            }
+        });
+
+        vertexCount += faceCount * 3 / 2;
+        faceCount *= 4;
+        std::swap(src, dst);
     }
 }
 
-void GeomCreate::createVertexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
+// === Compact vertices ===
+namespace {
+int16_t toSnorm16(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Projects the unit sphere onto the octahedron |x|+|y|+|z| = 1 and unfolds the lower
+// half over the diagonals, so every direction lands in [-1, 1]^2
+glm::vec2 octEncode(const glm::vec3& n) {
+    glm::vec3 p = n / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+    if (p.z >= 0.0f)
+        return glm::vec2(p.x, p.y);
+    return glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                     (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+uint64_t uploadVertexData(VkDevice device, GpuAllocator& allocator, UploadManager& uploader,
+                          const void* data, VkDeviceSize bufferSize,
+                          VkBuffer& vertexBuffer, GpuAllocation& vertexAllocation) {
+    createBuffer(device, allocator, bufferSize,
+                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 vertexBuffer, vertexAllocation);
+
+    return uploader.enqueueBufferUpload(vertexBuffer, 0, data, bufferSize,
+                                 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+}
+
+glm::vec3 GeomCreate::octDecode(glm::vec2 e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+float GeomCreate::packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& outPacked) {
+    float scale = 0.0f;
+    for (const auto& v : vertices)
+        scale = std::max({ scale, std::abs(v.position.x), std::abs(v.position.y), std::abs(v.position.z) });
+    if (scale == 0.0f)
+        scale = 1.0f;
+    const float invScale = 1.0f / scale;
+
+    outPacked.resize(vertices.size());
+    parallelFor(vertices.size(), 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Vertex& v = vertices[i];
+            glm::vec2 n = octEncode(v.normal);
+            outPacked[i] = { { toSnorm16(v.position.x * invScale), toSnorm16(v.position.y * invScale),
+                               toSnorm16(v.position.z * invScale), 0 },
+                             { toSnorm16(n.x), toSnorm16(n.y) } };
+        }
+    });
+    return scale;
+}
+
+uint32_t GeomCreate::vertexStride(VertexFormat format) {
+    return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// === Procedural spheres ===
+ProceduralPushConstants GeomCreate::proceduralPushConstants(const ProceduralSphere& sphere) {
+    ProceduralPushConstants pc{};
+    pc.shape = sphere.type == SphereType::UVSphere ? 0u : 1u;
+    pc.latDiv = std::max(sphere.latDiv, 2u);
+    pc.lonDiv = std::max(sphere.lonDiv, 3u);
+    pc.subdivisions = sphere.type == SphereType::LowPoly ? 0u : std::min(sphere.subdivisions, 10u);
+    return pc;
+}
+
+uint32_t GeomCreate::proceduralVertexCount(const ProceduralSphere& sphere) {
+    ProceduralPushConstants pc = proceduralPushConstants(sphere);
+    if (pc.shape == 0)
+        return pc.latDiv * pc.lonDiv * 6;
+    return (20u << (2 * pc.subdivisions)) * 3;
+}
+
+uint64_t GeomCreate::createVertexBuffer(VkDevice device, GpuAllocator& allocator,
+                                    UploadManager& uploader,
                                     const std::vector<Vertex>& vertices,
-                                    VkBuffer& vertexBuffer, VkDeviceMemory& vertexMemory) {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-    createBuffer(device, physicalDevice, bufferSize,
-                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 vertexBuffer, vertexMemory);
-
-    void* data;
-    vkMapMemory(device, vertexMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device, vertexMemory);
-}
-
-void GeomCreate::createIndexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
-                                   const std::vector<uint32_t>& indices,
-                                   VkBuffer& indexBuffer, VkDeviceMemory& indexMemory) {
+                                    VkBuffer& vertexBuffer, GpuAllocation& vertexAllocation) {
+    return uploadVertexData(device, allocator, uploader, vertices.data(), sizeof(vertices[0]) * vertices.size(),
+                            vertexBuffer, vertexAllocation);
+}
+
+uint64_t GeomCreate::createVertexBuffer(VkDevice device, GpuAllocator& allocator,
+                                    UploadManager& uploader,
+                                    const std::vector<PackedVertex>& vertices,
+                                    VkBuffer& vertexBuffer, GpuAllocation& vertexAllocation) {
+    return uploadVertexData(device, allocator, uploader, vertices.data(), sizeof(vertices[0]) * vertices.size(),
+                            vertexBuffer, vertexAllocation);
+}
+
+// === Icosphere LOD chain ===
+template <typename IndexT>
+void GeomCreate::createIcosphereLodChain(uint32_t maxSubdivisions,
+                                         std::vector<Vertex>& outVertices,
+                                         std::vector<IndexT>& outIndices,
+                                         std::vector<MeshLod>& outLods) {
+    if (maxSubdivisions > MaxIcosphereLodSubdivisions)
+        throw std::runtime_error("Too many icosphere LOD levels");
+
+    // The finest level provides the shared vertices; coarser levels only contribute indices
+    createIcosphere(maxSubdivisions, outVertices, outIndices);
+    std::vector<IndexT> finest;
+    finest.swap(outIndices);
+    outLods.clear();
+
+    std::vector<Vertex> levelVertices;
+    std::vector<IndexT> levelIndices;
+    for (uint32_t level = 0; level < maxSubdivisions; ++level) {
+        createIcosphere(level, levelVertices, levelIndices);
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(outIndices.size());
+        lod.indexCount = static_cast<uint32_t>(levelIndices.size());
+        lod.error = sphereApproximationError(levelVertices, levelIndices.data(), levelIndices.size());
+        outLods.push_back(lod);
+        outIndices.insert(outIndices.end(), levelIndices.begin(), levelIndices.end());
+    }
+
+    MeshLod lod;
+    lod.firstIndex = static_cast<uint32_t>(outIndices.size());
+    lod.indexCount = static_cast<uint32_t>(finest.size());
+    lod.error = 0.0f;  // nothing finer to switch to
+    outLods.push_back(lod);
+    outIndices.insert(outIndices.end(), finest.begin(), finest.end());
+}
+
+template <typename IndexT>
+float GeomCreate::sphereApproximationError(const std::vector<Vertex>& vertices,
+                                           const IndexT* indices, size_t indexCount) {
+    // A flat triangle strays furthest from the sphere where its plane is closest to the centre
+    float error = 0.0f;
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const glm::vec3& a = vertices[indices[i]].position;
+        const glm::vec3& b = vertices[indices[i + 1]].position;
+        const glm::vec3& c = vertices[indices[i + 2]].position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        float planeDistance = std::abs(glm::dot(normal / length, a));
+        error = std::max(error, 1.0f - planeDistance);
+    }
+    return error;
+}
+
+template <typename IndexT>
+uint64_t GeomCreate::createIndexBuffer(VkDevice device, GpuAllocator& allocator,
+                                   UploadManager& uploader,
+                                   const std::vector<IndexT>& indices,
+                                   VkBuffer& indexBuffer, GpuAllocation& indexAllocation) {
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-    createBuffer(device, physicalDevice, bufferSize,
-                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 indexBuffer, indexMemory);
+    createBuffer(device, allocator, bufferSize,
+                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 indexBuffer, indexAllocation);
+
+    return uploader.enqueueBufferUpload(indexBuffer, 0, indices.data(), bufferSize,
+                                 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+}
+
+template <typename IndexT>
+GpuMesh GeomCreate::createMesh(VkDevice device, GpuAllocator& allocator, UploadManager& uploader,
+                               const std::vector<Vertex>& vertices,
+                               const std::vector<IndexT>& indices,
+                               VertexFormat format) {
+    GpuMesh mesh;
+    createMesh(device, allocator, uploader, vertices, indices, format, mesh);
+    return mesh;
+}
+
+template <typename IndexT>
+void GeomCreate::createMesh(VkDevice device, GpuAllocator& allocator, UploadManager& uploader,
+                            const std::vector<Vertex>& vertices,
+                            const std::vector<IndexT>& indices,
+                            VertexFormat format, GpuMesh& mesh) {
+    mesh = GpuMesh{};
+    mesh.vertexFormat = format;
+    mesh.indexType = indexTypeOf<IndexT>();
+    if (format == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed;
+        mesh.positionScale = packVertices(vertices, packed);
+        createVertexBuffer(device, allocator, uploader, packed, mesh.vertexBuffer, mesh.vertexAllocation);
+    } else {
+        createVertexBuffer(device, allocator, uploader, vertices, mesh.vertexBuffer, mesh.vertexAllocation);
+    }
+    // Tickets are monotonic, so the later one covers both uploads
+    mesh.uploadTicket = createIndexBuffer(device, allocator, uploader, indices, mesh.indexBuffer, mesh.indexAllocation);
+    mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+    mesh.indexCount = static_cast<uint32_t>(indices.size());
+    mesh.lods[0].indexCount = mesh.indexCount;
+    mesh.lodCount = 1;
+}
 
-    void* data;
-    vkMapMemory(device, indexMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device, indexMemory);
+void GeomCreate::destroyMesh(VkDevice device, GpuAllocator& allocator, GpuMesh& mesh) {
+    destroyBuffer(device, allocator, mesh.vertexBuffer, mesh.vertexAllocation);
+    destroyBuffer(device, allocator, mesh.indexBuffer, mesh.indexAllocation);
+    mesh = GpuMesh{};
 }
 
+// === Index type instantiations ===
+template void GeomCreate::createUVSphere<uint16_t>(uint32_t, uint32_t, std::vector<Vertex>&, std::vector<uint16_t>&);
+template void GeomCreate::createIcosphere<uint16_t>(uint32_t, std::vector<Vertex>&, std::vector<uint16_t>&);
+template void GeomCreate::createLowPolySphere<uint16_t>(std::vector<Vertex>&, std::vector<uint16_t>&);
+template void GeomCreate::createIcosphereLodChain<uint16_t>(uint32_t, std::vector<Vertex>&, std::vector<uint16_t>&,
+                                                         std::vector<MeshLod>&);
+template float GeomCreate::sphereApproximationError<uint16_t>(const std::vector<Vertex>&, const uint16_t*, size_t);
+template uint64_t GeomCreate::createIndexBuffer<uint16_t>(VkDevice, GpuAllocator&, UploadManager&,
+                                                         const std::vector<uint16_t>&, VkBuffer&, GpuAllocation&);
+template GpuMesh GeomCreate::createMesh<uint16_t>(VkDevice, GpuAllocator&, UploadManager&, const std::vector<Vertex>&,
+                                                 const std::vector<uint16_t>&, VertexFormat);
+template void GeomCreate::createMesh<uint16_t>(VkDevice, GpuAllocator&, UploadManager&, const std::vector<Vertex>&,
+                                              const std::vector<uint16_t>&, VertexFormat, GpuMesh&);
+template void GeomCreate::createUVSphere<uint32_t>(uint32_t, uint32_t, std::vector<Vertex>&, std::vector<uint32_t>&);
+template void GeomCreate::createIcosphere<uint32_t>(uint32_t, std::vector<Vertex>&, std::vector<uint32_t>&);
+template void GeomCreate::createLowPolySphere<uint32_t>(std::vector<Vertex>&, std::vector<uint32_t>&);
+template void GeomCreate::createIcosphereLodChain<uint32_t>(uint32_t, std::vector<Vertex>&, std::vector<uint32_t>&,
+                                                         std::vector<MeshLod>&);
+template float GeomCreate::sphereApproximationError<uint32_t>(const std::vector<Vertex>&, const uint32_t*, size_t);
+template uint64_t GeomCreate::createIndexBuffer<uint32_t>(VkDevice, GpuAllocator&, UploadManager&,
+                                                         const std::vector<uint32_t>&, VkBuffer&, GpuAllocation&);
+template GpuMesh GeomCreate::createMesh<uint32_t>(VkDevice, GpuAllocator&, UploadManager&, const std::vector<Vertex>&,
+                                                 const std::vector<uint32_t>&, VertexFormat);
+template void GeomCreate::createMesh<uint32_t>(VkDevice, GpuAllocator&, UploadManager&, const std::vector<Vertex>&,
+                                              const std::vector<uint32_t>&, VertexFormat, GpuMesh&);
@@ -5,37 +5,115 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <HelpStructures.h>
+#include "GpuAllocator.h"
+#include "UploadManager.h"
+#include "Mesh.h"
 #define GLM_ENABLE_EXPERIMENTAL
 
 class GeomCreate {
 public:
     // === Sphere Generators ===
+    // IndexT is uint16_t or uint32_t. 16-bit output throws if the mesh needs more vertices
+    // than it can address; the *VertexCount functions tell up front (see fitsUint16).
 
     // UV Sphere (latitude-longitude grid)
+    template <typename IndexT>
     static void createUVSphere(uint32_t latDiv, uint32_t lonDiv,
                                std::vector<Vertex>& outVertices,
-                               std::vector<uint32_t>& outIndices);
+                               std::vector<IndexT>& outIndices);
 
     // Icosphere (based on subdivided icosahedron)
+    template <typename IndexT>
     static void createIcosphere(uint32_t subdivisions,
                                 std::vector<Vertex>& outVertices,
-                                std::vector<uint32_t>& outIndices);
+                                std::vector<IndexT>& outIndices);
+
+    // Icosphere levels 0..maxSubdivisions in one vertex and index array. Every level's
+    // vertices are a prefix of the finest level's, so all levels share the vertex array
+    // and differ only in their index range (outLods, coarsest first).
+    template <typename IndexT>
+    static void createIcosphereLodChain(uint32_t maxSubdivisions,
+                                        std::vector<Vertex>& outVertices,
+                                        std::vector<IndexT>& outIndices,
+                                        std::vector<MeshLod>& outLods);
+
+    // Largest distance between a triangle and the unit sphere it approximates
+    template <typename IndexT>
+    static float sphereApproximationError(const std::vector<Vertex>& vertices,
+                                          const IndexT* indices, size_t indexCount);
 
     // Hardcoded low-poly sphere for testing
+    template <typename IndexT>
     static void createLowPolySphere(
         std::vector<Vertex>& outVertices,
-        std::vector<uint32_t>& outIndices);
+        std::vector<IndexT>& outIndices);
+
+    static size_t uvSphereVertexCount(uint32_t latDiv, uint32_t lonDiv) {
+        return size_t(latDiv + 1) * (lonDiv + 1);
+    }
+    static size_t icosphereVertexCount(uint32_t subdivisions) {
+        return size_t(10) * (size_t(1) << (2 * subdivisions)) + 2;
+    }
+    static constexpr size_t LowPolyVertexCount = 12;
+    // Parameter ranges accepted from the command line; the UI sliders stay inside them
+    static constexpr uint32_t MinSphereDivisions = 3;
+    static constexpr uint32_t MaxSphereDivisions = 256;
+    static constexpr uint32_t MaxIcosphereSubdivisions = 8;
+    // One level per subdivision count from 0, and a mesh holds at most MaxMeshLods
+    static constexpr uint32_t MaxIcosphereLodSubdivisions = MaxMeshLods - 1;
+    // Primitive restart is off, so all 65536 values are usable
+    static constexpr bool fitsUint16(size_t vertexCount) { return vertexCount <= 65536; }
+
+    // === Procedural spheres ===
+    // What sphere_procedural*.vert needs to draw `sphere`: its push constants and the
+    // vertex count of the non-indexed draw (three per triangle)
+    static ProceduralPushConstants proceduralPushConstants(const ProceduralSphere& sphere);
+    static uint32_t proceduralVertexCount(const ProceduralSphere& sphere);
+
+    // === Compact vertices ===
+    // Quantizes positions against their largest absolute component and octahedral-encodes
+    // normals. Returns the scale the decoded positions must be multiplied by.
+    static float packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& outPacked);
+    // Decodes an octahedral-encoded normal exactly like shaders/packed_vertex.glsl
+    static glm::vec3 octDecode(glm::vec2 e);
+    static uint32_t vertexStride(VertexFormat format);
 
     // === Vulkan Buffer Creation ===
-    static void createVertexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
+    // Buffers are DEVICE_LOCAL; contents are streamed through the uploader and become
+    // visible to the graphics queue from the next submitted frame onwards.
+    // Both return the upload ticket (see UploadManager::isComplete).
+    static uint64_t createVertexBuffer(VkDevice device, GpuAllocator& allocator,
+                                   UploadManager& uploader,
                                    const std::vector<Vertex>& vertices,
-                                   VkBuffer& vertexBuffer, VkDeviceMemory& vertexMemory);
+                                   VkBuffer& vertexBuffer, GpuAllocation& vertexAllocation);
+    static uint64_t createVertexBuffer(VkDevice device, GpuAllocator& allocator,
+                                   UploadManager& uploader,
+                                   const std::vector<PackedVertex>& vertices,
+                                   VkBuffer& vertexBuffer, GpuAllocation& vertexAllocation);
+
+    template <typename IndexT>
+    static uint64_t createIndexBuffer(VkDevice device, GpuAllocator& allocator,
+                                  UploadManager& uploader,
+                                  const std::vector<IndexT>& indices,
+                                  VkBuffer& indexBuffer, GpuAllocation& indexAllocation);
 
-    static void createIndexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
-                                  const std::vector<uint32_t>& indices,
-                                  VkBuffer& indexBuffer, VkDeviceMemory& indexMemory);
+    // Creates and uploads both buffers, packing the vertices first if `format` asks for it.
+    // The mesh records the index type to bind. Safe to call from worker threads.
+    template <typename IndexT>
+    static GpuMesh createMesh(VkDevice device, GpuAllocator& allocator, UploadManager& uploader,
+                              const std::vector<Vertex>& vertices,
+                              const std::vector<IndexT>& indices,
+                              VertexFormat format = VertexFormat::Float32);
+    // Same, building into `mesh` in place. If a buffer fails, `mesh` keeps the ones already
+    // created, whose uploads may be in flight, so the caller can retire them.
+    template <typename IndexT>
+    static void createMesh(VkDevice device, GpuAllocator& allocator, UploadManager& uploader,
+                           const std::vector<Vertex>& vertices,
+                           const std::vector<IndexT>& indices,
+                           VertexFormat format, GpuMesh& mesh);
+    static void destroyMesh(VkDevice device, GpuAllocator& allocator, GpuMesh& mesh);
 
     // Vertex input binding/attribute descriptions
-    static VkVertexInputBindingDescription getBindingDescription();
-    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+    static VkVertexInputBindingDescription getBindingDescription(VertexFormat format = VertexFormat::Float32);
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexFormat format = VertexFormat::Float32);
 };
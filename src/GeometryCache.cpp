@@ -0,0 +1,110 @@
+// GeometryCache.cpp
+#include "GeometryCache.h"
+#include "GeomCreate.h"
+#include <algorithm>
+
+GeometryRequest GeometryCache::normalize(const GeometryRequest& request) {
+    GeometryRequest normalized = request;
+    switch (request.type) {
+    case SphereType::LowPoly:
+        normalized.latDiv = normalized.lonDiv = normalized.subdivisions = 0;
+        break;
+    case SphereType::UVSphere:
+        normalized.subdivisions = 0;
+        break;
+    case SphereType::Icosphere:
+        normalized.latDiv = normalized.lonDiv = 0;
+        break;
+    case SphereType::IcosphereLod:
+        normalized.latDiv = normalized.lonDiv = 0;
+        normalized.subdivisions = std::min(normalized.subdivisions, GeomCreate::MaxIcosphereLodSubdivisions);
+        break;
+    }
+    return normalized;
+}
+
+GeometryCache::Key GeometryCache::keyFor(const GeometryRequest& request) {
+    GeometryRequest normalized = normalize(request);
+    return Key{ normalized.type, normalized.latDiv, normalized.lonDiv, normalized.subdivisions,
+                normalized.vertexFormat, normalized.optimize };
+}
+
+void GeometryCache::setBudget(size_t bytes, std::vector<GpuMesh>& evicted) {
+    budget = bytes;
+    evictToBudget(evicted);
+}
+
+const GeometryResult* GeometryCache::find(const GeometryRequest& request) {
+    auto it = lookup.find(keyFor(request));
+    if (it == lookup.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    stats.hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->result;
+}
+
+const GeometryResult* GeometryCache::insert(GeometryResult&& result, std::vector<GpuMesh>& evicted) {
+    Key key = keyFor(result.request);
+    auto existing = lookup.find(key);
+    if (existing != lookup.end()) {
+        // A duplicate build (e.g. a scrub back to a key whose first build was still in
+        // flight). The cached mesh may be the one on screen, so keep it and hand the new
+        // one back instead.
+        evicted.push_back(result.mesh);
+        entries.splice(entries.begin(), entries, existing->second);
+        return &existing->second->result;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.cpuBytes = result.vertices.capacity() * sizeof(Vertex) + result.indices16.capacity() * sizeof(uint16_t) +
+                     result.indices32.capacity() * sizeof(uint32_t);
+    entry.gpuBytes = static_cast<size_t>(result.mesh.vertexAllocation.size + result.mesh.indexAllocation.size);
+    entry.result = std::move(result);
+
+    stats.cpuBytes += entry.cpuBytes;
+    stats.gpuBytes += entry.gpuBytes;
+    entries.push_front(std::move(entry));
+    lookup[key] = entries.begin();
+    stats.entries = static_cast<uint32_t>(entries.size());
+
+    evictToBudget(evicted);
+    auto it = lookup.find(key);
+    return it != lookup.end() ? &it->second->result : nullptr;
+}
+
+void GeometryCache::pin(const GeometryRequest& request) {
+    pinned = keyFor(request);
+    hasPinned = true;
+}
+
+void GeometryCache::clear(std::vector<GpuMesh>& evicted) {
+    while (!entries.empty())
+        erase(std::prev(entries.end()), evicted);
+    hasPinned = false;
+}
+
+void GeometryCache::erase(std::list<Entry>::iterator it, std::vector<GpuMesh>& evicted) {
+    stats.cpuBytes -= it->cpuBytes;
+    stats.gpuBytes -= it->gpuBytes;
+    evicted.push_back(it->result.mesh);
+    lookup.erase(it->key);
+    entries.erase(it);
+    stats.entries = static_cast<uint32_t>(entries.size());
+}
+
+void GeometryCache::evictToBudget(std::vector<GpuMesh>& evicted) {
+    // Walk from the least recently used end, skipping the pinned entry
+    auto it = entries.end();
+    while (stats.cpuBytes + stats.gpuBytes > budget && it != entries.begin()) {
+        --it;
+        if (hasPinned && it->key == pinned)
+            continue;
+        auto victim = it;
+        ++it;  // stays valid: list erase only invalidates the victim
+        erase(victim, evicted);
+        stats.evictions++;
+    }
+}
@@ -0,0 +1,90 @@
+// GeometryCache.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "GeometryWorker.h"
+
+struct GeometryCacheStats {
+    uint32_t entries = 0;
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+// LRU cache of built sphere meshes, keyed by type plus the parameters that affect it.
+//
+// Entries hold the resident GpuMesh and the CPU arrays it came from. The cache owns the
+// meshes: anything it evicts is handed back to the caller to retire through
+// GraphicsModule::retireMesh, since the GPU may still be drawing it. The entry marked with
+// pin() (the mesh on screen) is never evicted, even if it alone exceeds the budget.
+// Render thread only.
+class GeometryCache {
+public:
+    void setBudget(size_t bytes, std::vector<GpuMesh>& evicted);
+    size_t getBudget() const { return budget; }
+
+    // Resident build for the request, or nullptr. A hit makes the entry most recently used.
+    const GeometryResult* find(const GeometryRequest& request);
+    // Takes ownership of a finished build. If the key is already cached, the existing entry
+    // wins and the new mesh is handed back through `evicted`. Returns the cached build, or
+    // nullptr if the entry did not fit the budget.
+    const GeometryResult* insert(GeometryResult&& result, std::vector<GpuMesh>& evicted);
+    // Marks the mesh on screen; pin before showing a mesh so it cannot be evicted under it
+    void pin(const GeometryRequest& request);
+    // Hands every mesh back, e.g. at shutdown
+    void clear(std::vector<GpuMesh>& evicted);
+
+    const GeometryCacheStats& getStats() const { return stats; }
+
+    // Parameters the generator ignores are zeroed, so e.g. every low-poly request is one key.
+    // An icosphere LOD chain is capped at the levels a mesh can hold; send the normalized
+    // request to the worker so it builds what the key says.
+    static GeometryRequest normalize(const GeometryRequest& request);
+
+private:
+    struct Key {
+        SphereType type;
+        uint32_t latDiv, lonDiv, subdivisions;
+        VertexFormat vertexFormat;
+        bool optimize;
+        bool operator==(const Key& other) const {
+            return type == other.type && latDiv == other.latDiv && lonDiv == other.lonDiv &&
+                   subdivisions == other.subdivisions && vertexFormat == other.vertexFormat &&
+                   optimize == other.optimize;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            uint64_t h = static_cast<uint64_t>(key.type);
+            h = h * 0x9E3779B97F4A7C15ull + key.latDiv;
+            h = h * 0x9E3779B97F4A7C15ull + key.lonDiv;
+            h = h * 0x9E3779B97F4A7C15ull + key.subdivisions;
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(key.vertexFormat);
+            h = h * 0x9E3779B97F4A7C15ull + key.optimize;
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+    struct Entry {
+        Key key;
+        GeometryResult result;
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+    };
+
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> lookup;
+    size_t budget = 256ull * 1024 * 1024;
+    Key pinned{ SphereType::LowPoly, 0, 0, 0, VertexFormat::Float32, false };
+    bool hasPinned = false;
+    GeometryCacheStats stats;
+
+    static Key keyFor(const GeometryRequest& request);
+    void erase(std::list<Entry>::iterator it, std::vector<GpuMesh>& evicted);
+    void evictToBudget(std::vector<GpuMesh>& evicted);
+};
@@ -0,0 +1,235 @@
+// GeometryWorker.cpp
+#include "GeometryWorker.h"
+#include "GeomCreate.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+void GeometryWorker::start(VkDevice inDevice, GpuAllocator& inAllocator, UploadManager& inUploader) {
+    device = inDevice;
+    allocator = &inAllocator;
+    uploader = &inUploader;
+
+    running = true;
+    thread = std::thread(&GeometryWorker::run, this);
+}
+
+void GeometryWorker::stop(std::vector<GpuMesh>& leftovers) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_one();
+    if (thread.joinable())
+        thread.join();
+
+    if (ready.mesh.valid())
+        leftovers.push_back(ready.mesh);
+    leftovers.insert(leftovers.end(), superseded.begin(), superseded.end());
+    ready = GeometryResult{};
+    superseded.clear();
+}
+
+void GeometryWorker::request(const GeometryRequest& request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = request;
+        requestedGeneration++;
+    }
+    wake.notify_one();
+}
+
+void GeometryWorker::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A build in progress sees the new generation and skips its upload; nothing new is
+    // picked up because the worker only wakes for a generation it has not started
+    requestedGeneration++;
+    buildingGeneration = requestedGeneration;
+}
+
+bool GeometryWorker::takeCompleted(GeometryResult& result, std::vector<GpuMesh>& outSuperseded) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    outSuperseded.insert(outSuperseded.end(), superseded.begin(), superseded.end());
+    superseded.clear();
+
+    // A failed build has nothing to upload; hand the error over straight away
+    if (ready.error.empty() && (!ready.mesh.valid() || !uploader->isComplete(ready.mesh.uploadTicket)))
+        return false;
+
+    result = std::move(ready);
+    ready = GeometryResult{};
+    return true;
+}
+
+bool GeometryWorker::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return building || buildingGeneration != requestedGeneration || ready.mesh.valid() || !ready.error.empty();
+}
+
+double GeometryWorker::getLastBuildMs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastBuildMs;
+}
+
+void GeometryWorker::run() {
+    Tracer::get().setThreadName("Geometry worker");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&] { return !running || buildingGeneration != requestedGeneration; });
+        if (!running)
+            return;
+
+        GeometryRequest request = pending;
+        uint64_t generation = requestedGeneration;
+        buildingGeneration = generation;
+        building = true;
+
+        lock.unlock();
+        auto buildStart = std::chrono::steady_clock::now();
+        GeometryResult result;
+        result.request = request;
+        bool uploaded = false;
+        try {
+            uploaded = build(generation, result);
+        } catch (const std::exception& e) {
+            // Out of memory, a mesh too large for its index type, a failed buffer allocation:
+            // reported to the render thread instead of ending the process
+            result.error = e.what();
+        }
+        lock.lock();
+        building = false;
+
+        // Buffers created before the failure may have uploads in flight; retire them
+        if (!result.error.empty()) {
+            if (result.mesh.vertexBuffer != VK_NULL_HANDLE || result.mesh.indexBuffer != VK_NULL_HANDLE)
+                superseded.push_back(result.mesh);
+            result.mesh = GpuMesh{};
+        }
+        // Superseded while generating: start on the newer request. A failure nobody wants
+        // any more is dropped too.
+        if (result.error.empty() ? !uploaded : generation != requestedGeneration)
+            continue;
+
+        // A finished mesh nobody took yet is stale now; hand it back for deferred destruction
+        if (ready.mesh.valid())
+            superseded.push_back(ready.mesh);
+        ready = std::move(result);
+        if (ready.error.empty())
+            lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    }
+}
+
+bool GeometryWorker::build(uint64_t generation, GeometryResult& result) {
+    const GeometryRequest& request = result.request;
+    // 16-bit indices whenever the vertex count allows: half the index memory and bandwidth
+    const bool narrow = GeomCreate::fitsUint16(vertexCount(request));
+    {
+        TraceScope scope("Generate geometry", "geometry");
+        if (narrow)
+            generate(request, result.vertices, result.indices16, result.lods);
+        else
+            generate(request, result.vertices, result.indices32, result.lods);
+    }
+    {
+        TraceScope scope("Optimize mesh", "geometry");
+        result.optimizerStats = narrow ? optimize(request, result.vertices, result.indices16, result.lods)
+                                       : optimize(request, result.vertices, result.indices32, result.lods);
+    }
+
+    // Superseded while generating: skip the upload
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (generation != requestedGeneration || !running)
+            return false;
+    }
+
+    {
+        TraceScope scope("Create and upload mesh", "geometry");
+        if (narrow)
+            GeomCreate::createMesh(device, *allocator, *uploader, result.vertices, result.indices16,
+                                   request.vertexFormat, result.mesh);
+        else
+            GeomCreate::createMesh(device, *allocator, *uploader, result.vertices, result.indices32,
+                                   request.vertexFormat, result.mesh);
+    }
+    if (!result.lods.empty()) {
+        std::copy(result.lods.begin(), result.lods.end(), result.mesh.lods);
+        result.mesh.lodCount = static_cast<uint32_t>(result.lods.size());
+    }
+    return true;
+}
+
+size_t GeometryWorker::vertexCount(const GeometryRequest& request) {
+    switch (request.type) {
+    case SphereType::LowPoly:
+        return GeomCreate::LowPolyVertexCount;
+    case SphereType::UVSphere:
+        return GeomCreate::uvSphereVertexCount(request.latDiv, request.lonDiv);
+    case SphereType::Icosphere:
+    case SphereType::IcosphereLod:
+        return GeomCreate::icosphereVertexCount(request.subdivisions);
+    }
+    return 0;
+}
+
+template <typename IndexT>
+void GeometryWorker::generate(const GeometryRequest& request, std::vector<Vertex>& vertices,
+                              std::vector<IndexT>& indices, std::vector<MeshLod>& lods) {
+    lods.clear();
+    switch (request.type) {
+    case SphereType::LowPoly:
+        GeomCreate::createLowPolySphere(vertices, indices);
+        break;
+    case SphereType::UVSphere:
+        GeomCreate::createUVSphere(request.latDiv, request.lonDiv, vertices, indices);
+        break;
+    case SphereType::Icosphere:
+        GeomCreate::createIcosphere(request.subdivisions, vertices, indices);
+        break;
+    case SphereType::IcosphereLod:
+        GeomCreate::createIcosphereLodChain(request.subdivisions, vertices, indices, lods);
+        break;
+    }
+}
+
+template <typename IndexT>
+MeshOptimizerStats GeometryWorker::optimize(const GeometryRequest& request, std::vector<Vertex>& vertices,
+                                            std::vector<IndexT>& indices, const std::vector<MeshLod>& lods) {
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (request.optimize && lods.empty())
+        return MeshOptimizer::optimize(vertices, indices);
+
+    MeshOptimizerStats stats;
+    stats.before = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+    std::vector<IndexT> range;
+    auto analyzeLods = [&](std::vector<VertexCacheStats>& out) {
+        for (const auto& lod : lods) {
+            range.assign(indices.begin() + lod.firstIndex, indices.begin() + lod.firstIndex + lod.indexCount);
+            out.push_back(MeshOptimizer::analyzeVertexCache(range, vertexCount));
+        }
+    };
+    analyzeLods(stats.lodBefore);
+    if (request.optimize) {
+        // Triangles are reordered within each level; the vertex renumbering is one remap
+        // over the concatenated ranges, so every level stays valid. Levels run coarsest
+        // first, so each level's vertices are still a prefix of the next level's
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& lod : lods) {
+            auto first = indices.begin() + lod.firstIndex;
+            range.assign(first, first + lod.indexCount);
+            MeshOptimizer::optimizeVertexCache(range, vertexCount);
+            std::copy(range.begin(), range.end(), first);
+        }
+        MeshOptimizer::optimizeVertexFetch(vertices, indices);
+        stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.optimized = true;
+    }
+    stats.after = stats.optimized ? MeshOptimizer::analyzeVertexCache(indices, vertexCount) : stats.before;
+    if (stats.optimized)
+        analyzeLods(stats.lodAfter);
+    else
+        stats.lodAfter = stats.lodBefore;
+    return stats;
+}
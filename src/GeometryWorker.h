@@ -0,0 +1,103 @@
+// GeometryWorker.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HelpStructures.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+class GpuAllocator;
+class UploadManager;
+
+struct GeometryRequest {
+    SphereType type = SphereType::LowPoly;
+    uint32_t latDiv = 16;
+    uint32_t lonDiv = 16;
+    uint32_t subdivisions = 1;
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    bool optimize = true;  // reorder for the vertex cache and vertex fetch (MeshOptimizer)
+
+    bool operator==(const GeometryRequest& other) const {
+        return type == other.type && latDiv == other.latDiv && lonDiv == other.lonDiv &&
+               subdivisions == other.subdivisions && vertexFormat == other.vertexFormat &&
+               optimize == other.optimize;
+    }
+};
+
+// A finished build: the resident mesh plus the CPU arrays it was uploaded from
+struct GeometryResult {
+    GeometryRequest request;
+    GpuMesh mesh;
+    std::vector<Vertex> vertices;
+    // Exactly one is filled, matching mesh.indexType
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;
+    std::vector<MeshLod> lods;  // empty for single-level meshes
+    MeshOptimizerStats optimizerStats;
+    std::string error;  // set instead of a mesh when the build threw
+};
+
+// Background sphere generation and upload.
+//
+// request() never blocks: it replaces whatever request is still waiting, so a slider drag
+// only builds the newest parameters, and a request superseded during generation is
+// dropped before its upload. The worker generates the mesh, creates its buffers
+// and enqueues the uploads; the render thread keeps flushing the uploader every frame and
+// picks the mesh up with takeCompleted() once the transfer has finished on the GPU.
+class GeometryWorker {
+public:
+    void start(VkDevice device, GpuAllocator& allocator, UploadManager& uploader);
+    // Joins the worker. Meshes it still holds are appended to `leftovers` for the caller to retire.
+    void stop(std::vector<GpuMesh>& leftovers);
+
+    void request(const GeometryRequest& request);
+    // Drops the waiting request and abandons a build in progress before its upload
+    void cancel();
+
+    // Called at a frame boundary on the render thread. Returns true and fills `result` when
+    // the newest finished mesh is resident, or when the newest build failed: `result.error`
+    // is set then and `result.mesh` is invalid. Meshes that were superseded before being taken are
+    // appended to `superseded`; their uploads may still be in flight, so retire them like any
+    // other buffer the GPU may touch.
+    bool takeCompleted(GeometryResult& result, std::vector<GpuMesh>& superseded);
+
+    bool isBusy() const;
+    // Wall time of the last finished build: generation plus buffer creation and upload enqueue
+    double getLastBuildMs() const;
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    UploadManager* uploader = nullptr;
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+
+    GeometryRequest pending;
+    uint64_t requestedGeneration = 0;   // bumped by request()
+    uint64_t buildingGeneration = 0;    // last generation the worker picked up
+    bool building = false;
+    double lastBuildMs = 0.0;
+
+    GeometryResult ready;               // newest finished mesh, not yet taken
+    std::vector<GpuMesh> superseded;    // finished meshes replaced before they were taken
+
+    void run();
+    // Generates and uploads `result.request`; false if superseded before the upload
+    bool build(uint64_t generation, GeometryResult& result);
+    static size_t vertexCount(const GeometryRequest& request);
+    template <typename IndexT>
+    static void generate(const GeometryRequest& request, std::vector<Vertex>& vertices,
+                         std::vector<IndexT>& indices, std::vector<MeshLod>& lods);
+    template <typename IndexT>
+    static MeshOptimizerStats optimize(const GeometryRequest& request, std::vector<Vertex>& vertices,
+                                       std::vector<IndexT>& indices, const std::vector<MeshLod>& lods);
+};
@@ -0,0 +1,247 @@
+// GpuAllocator.cpp
+#include "GpuAllocator.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+void GpuAllocator::init(VkDevice inDevice, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize) {
+    device = inDevice;
+    preferredBlockSize = blockSize;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+    nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+}
+
+void GpuAllocator::cleanup() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& typeBlocks : blocks) {
+        for (auto& block : typeBlocks)
+            destroyBlock(*block);
+        typeBlocks.clear();
+    }
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) &&
+            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("Failed to find suitable memory type for buffer");
+}
+
+VkDeviceSize GpuAllocator::blockSizeForType(uint32_t memoryType) const {
+    // Small heaps (e.g. the 256 MB BAR window) get proportionally smaller blocks
+    VkDeviceSize heapSize = memProperties.memoryHeaps[memProperties.memoryTypes[memoryType].heapIndex].size;
+    return std::min(preferredBlockSize, std::max<VkDeviceSize>(heapSize / 8, 1024 * 1024));
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& inRequirements, VkMemoryPropertyFlags properties,
+                                     bool optimalImage) {
+    uint32_t memoryType = findMemoryType(inRequirements.memoryTypeBits, properties);
+    VkMemoryRequirements requirements = inRequirements;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    if (optimalImage) {
+        // Pad to whole granularity pages so neighbouring buffers never share one
+        alignment = std::max(alignment, bufferImageGranularity);
+        requirements.size = alignUp(requirements.size, bufferImageGranularity);
+    }
+    VkMemoryPropertyFlags typeFlags = memProperties.memoryTypes[memoryType].propertyFlags;
+    if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        // Flush/invalidate ranges are widened to whole atoms, so keep each allocation on its own
+        alignment = std::max(alignment, nonCoherentAtomSize);
+        requirements.size = alignUp(requirements.size, nonCoherentAtomSize);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Block* target = nullptr;
+    VkDeviceSize offset = 0;
+    VkDeviceSize blockSize = blockSizeForType(memoryType);
+
+    if (requirements.size > blockSize / 2) {
+        target = createBlock(memoryType, requirements.size, true);
+        offset = 0;
+        target->freeRanges.clear();
+    } else {
+        for (auto& block : blocks[memoryType]) {
+            if (!block->dedicated && allocateFromBlock(*block, requirements.size, alignment, offset)) {
+                target = block.get();
+                break;
+            }
+        }
+        if (!target) {
+            target = createBlock(memoryType, blockSize, false);
+            if (!allocateFromBlock(*target, requirements.size, alignment, offset))
+                throw std::runtime_error("Failed to sub-allocate from a fresh memory block");
+        }
+    }
+
+    target->used += requirements.size;
+    target->allocationCount++;
+
+    GpuAllocation allocation;
+    allocation.memory = target->memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.memoryType = memoryType;
+    allocation.mapped = target->mapped ? static_cast<uint8_t*>(target->mapped) + offset : nullptr;
+    return allocation;
+}
+
+void GpuAllocator::free(GpuAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& typeBlocks = blocks[allocation.memoryType];
+    auto it = std::find_if(typeBlocks.begin(), typeBlocks.end(),
+                           [&](const std::unique_ptr<Block>& b) { return b->memory == allocation.memory; });
+    if (it == typeBlocks.end())
+        throw std::runtime_error("Freeing an allocation that does not belong to this allocator");
+
+    Block& block = **it;
+    block.used -= allocation.size;
+    block.allocationCount--;
+
+    if (!block.dedicated) {
+        // Return the range and coalesce with its neighbours
+        VkDeviceSize start = allocation.offset;
+        VkDeviceSize end = allocation.offset + allocation.size;
+
+        auto next = block.freeRanges.lower_bound(start);
+        if (next != block.freeRanges.end() && next->first == end) {
+            end += next->second;
+            next = block.freeRanges.erase(next);
+        }
+        if (next != block.freeRanges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == start) {
+                start = prev->first;
+                block.freeRanges.erase(prev);
+            }
+        }
+        block.freeRanges[start] = end - start;
+    }
+
+    if (block.allocationCount == 0) {
+        // Keep one empty block per type for reuse; release dedicated and surplus blocks
+        bool keep = !block.dedicated &&
+                    std::none_of(typeBlocks.begin(), typeBlocks.end(), [&](const std::unique_ptr<Block>& b) {
+                        return b.get() != &block && !b->dedicated && b->allocationCount == 0;
+                    });
+        if (!keep) {
+            destroyBlock(block);
+            typeBlocks.erase(it);
+        }
+    }
+
+    allocation = GpuAllocation{};
+}
+
+GpuAllocatorStats GpuAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    GpuAllocatorStats stats;
+    stats.deviceAllocateCalls = deviceAllocateCalls;
+    // Free ranges of one memory type cannot serve another, so fragmentation is measured per
+    // type and weighted by that type's share of the free bytes
+    VkDeviceSize totalFree = 0;
+    VkDeviceSize fragmentedFree = 0;
+    for (const auto& typeBlocks : blocks) {
+        VkDeviceSize typeFree = 0;
+        VkDeviceSize typeLargest = 0;
+        for (const auto& block : typeBlocks) {
+            stats.blockCount++;
+            stats.allocationCount += block->allocationCount;
+            stats.bytesReserved += block->size;
+            stats.bytesUsed += block->used;
+            for (const auto& range : block->freeRanges) {
+                typeFree += range.second;
+                typeLargest = std::max(typeLargest, range.second);
+            }
+        }
+        fragmentedFree += typeFree - typeLargest;
+        totalFree += typeFree;
+        stats.largestFreeRange = std::max(stats.largestFreeRange, typeLargest);
+    }
+    if (totalFree > 0)
+        stats.fragmentation = static_cast<float>(fragmentedFree) / static_cast<float>(totalFree);
+    return stats;
+}
+
+GpuAllocator::Block* GpuAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, bool dedicated) {
+    auto block = std::make_unique<Block>();
+    block->size = size;
+    block->dedicated = dedicated;
+
+    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate buffer memory");
+
+    if (memProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, block->memory, nullptr);
+            throw std::runtime_error("Failed to map memory block");
+        }
+    }
+
+    // Only count blocks that made it into the pool, so the stat matches live + released blocks
+    deviceAllocateCalls++;
+    block->freeRanges[0] = size;
+    blocks[memoryType].push_back(std::move(block));
+    return blocks[memoryType].back().get();
+}
+
+void GpuAllocator::destroyBlock(Block& block) {
+    if (block.mapped)
+        vkUnmapMemory(device, block.memory);
+    vkFreeMemory(device, block.memory, nullptr);
+    block.memory = VK_NULL_HANDLE;
+    block.mapped = nullptr;
+}
+
+bool GpuAllocator::allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+    // Best fit: the free range that leaves the least slack after alignment
+    auto best = block.freeRanges.end();
+    VkDeviceSize bestSlack = ~VkDeviceSize(0);
+    for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+        VkDeviceSize aligned = alignUp(it->first, alignment);
+        VkDeviceSize end = it->first + it->second;
+        if (aligned + size > end)
+            continue;
+        VkDeviceSize slack = end - (aligned + size);
+        if (slack < bestSlack) {
+            best = it;
+            bestSlack = slack;
+            if (slack == 0) break;
+        }
+    }
+    if (best == block.freeRanges.end())
+        return false;
+
+    VkDeviceSize rangeStart = best->first;
+    VkDeviceSize rangeEnd = best->first + best->second;
+    offset = alignUp(rangeStart, alignment);
+    block.freeRanges.erase(best);
+
+    // Alignment padding stays in the free list so it can be coalesced later
+    if (offset > rangeStart)
+        block.freeRanges[rangeStart] = offset - rangeStart;
+    if (offset + size < rangeEnd)
+        block.freeRanges[offset + size] = rangeEnd - (offset + size);
+    return true;
+}
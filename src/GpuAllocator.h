@@ -0,0 +1,77 @@
+// GpuAllocator.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A sub-range of a device memory block handed out by GpuAllocator
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;   // host pointer for HOST_VISIBLE memory, persistently mapped
+    uint32_t memoryType = 0;
+};
+
+struct GpuAllocatorStats {
+    uint32_t blockCount = 0;           // live vkAllocateMemory objects
+    uint32_t allocationCount = 0;      // live sub-allocations
+    uint64_t deviceAllocateCalls = 0;  // vkAllocateMemory calls since init
+    VkDeviceSize bytesReserved = 0;    // sum of block sizes
+    VkDeviceSize bytesUsed = 0;        // sum of sub-allocation sizes
+    VkDeviceSize largestFreeRange = 0;
+    float fragmentation = 0.0f;        // per memory type 1 - largest free range / free bytes,
+                                       // weighted by free bytes
+};
+
+// Block allocator for buffer and image memory.
+//
+// Each memory type owns a list of large blocks carved up with a best-fit free list
+// (offset-ordered, coalesced on free). Requests larger than half a block get a dedicated
+// block. Empty blocks are kept around once per memory type so that geometry churn reuses
+// memory instead of round-tripping through the driver. Thread-safe.
+class GpuAllocator {
+public:
+    void init(VkDevice device, VkPhysicalDevice physicalDevice,
+              VkDeviceSize blockSize = 64ull * 1024 * 1024);
+    void cleanup();
+
+    // optimalImage: the resource is an optimally tiled image, which must not share a
+    // bufferImageGranularity page with linear resources
+    GpuAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                           bool optimalImage = false);
+    void free(GpuAllocation& allocation);
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memProperties; }
+    GpuAllocatorStats getStats() const;
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        VkDeviceSize used = 0;
+        uint32_t allocationCount = 0;
+        void* mapped = nullptr;
+        bool dedicated = false;
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges; // offset -> size
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProperties{};
+    VkDeviceSize preferredBlockSize = 0;
+    VkDeviceSize bufferImageGranularity = 1;
+    VkDeviceSize nonCoherentAtomSize = 1;
+    uint64_t deviceAllocateCalls = 0;
+
+    std::vector<std::unique_ptr<Block>> blocks[VK_MAX_MEMORY_TYPES];
+    mutable std::mutex mutex;
+
+    Block* createBlock(uint32_t memoryType, VkDeviceSize size, bool dedicated);
+    void destroyBlock(Block& block);
+    bool allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    VkDeviceSize blockSizeForType(uint32_t memoryType) const;
+};
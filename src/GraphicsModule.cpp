@@ -3,25 +3,81 @@
 #include "backends/imgui_impl_sdl3.h"
 #include "VulkanHelperMethods.h"
 #include "GeomCreate.h"
+#include "Tracer.h"
 #include <fstream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 
 // --- Public Init Method ---
+void GraphicsModule::setHeadless(uint32_t width, uint32_t height) {
+    headless = true;
+    headlessExtent = { width, height };
+}
+
 void GraphicsModule::init() {
-    initSDL();
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    auto initStart = Clock::now();
+
+    if (!headless) {
+        initSDL();
+    }
     createVulkanInstance();
-    createSurface();
+    if (!headless) {
+        createSurface();
+    }
     pickPhysicalDevice();
     createLogicalDevice();
+
+    allocator.init(device, physicalDevice);
+    uploader.init(device, allocator,
+                  graphicsQueueFamilyIndex, graphicsQueue,
+                  transferQueueFamilyIndex, transferQueue);
+    startupStats.deviceMs = msSince(initStart);
+
+    auto swapchainStart = Clock::now();
     createSwapchain();
     createImageViews();
-    createRenderPass();
+    createDepthResources();
     createCommandPoolAndBuffers();
-    createFramebuffers();
+    createSyncObjects();
+    createTimestampQueries();
+    profiler.init(device, physicalDevice, graphicsQueueFamilyIndex, maxFramesInFlight);
+    recorder.init(device, graphicsQueueFamilyIndex, maxFramesInFlight, recordWorkers);
 
+    instanceBuffer.init(device, allocator, maxFramesInFlight);
+    createCameraBuffers();
+
+    camera.setViewport(static_cast<float>(swapchainExtent.width),
+                       static_cast<float>(swapchainExtent.height));
+    startupStats.swapchainMs = msSince(swapchainStart);
+
+    auto pipelinesStart = Clock::now();
+    pipelineCache.init(device, physicalDevice, pipelineCachePath);
+    culler.init(device, allocator, maxFramesInFlight,
+                instanceBuffer.getDescriptorSetLayout(), drawIndirectCountSupported,
+                pipelineCache.get());
     createGraphicsPipeline();
+    startupStats.pipelinesMs = msSince(pipelinesStart);
+
+    startupStats.totalMs = msSince(initStart);
+    startupStats.pipelineCacheWarm = pipelineCache.isWarm();
+    startupStats.pipelineCacheBytes = pipelineCache.getLoadedBytes();
+
+    std::string cacheState = pipelineCache.isWarm()
+        ? "warm, " + std::to_string(pipelineCache.getLoadedBytes() / 1024) + " KB"
+        : pipelineCache.getRejectReason().empty() ? std::string("cold")
+                                                  : "cold, " + pipelineCache.getRejectReason();
+    fprintf(stderr, "[startup] device %.1f ms, swapchain %.1f ms, pipelines %.1f ms (%s), total %.1f ms\n",
+                    startupStats.deviceMs, startupStats.swapchainMs, startupStats.pipelinesMs,
+                    cacheState.c_str(), startupStats.totalMs);
 }
 
 // --- Private Initialization Steps ---
@@ -43,16 +99,18 @@ void GraphicsModule::createVulkanInstance() {
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion = VK_API_VERSION_1_3;
 
-    uint32_t sdlExtCount = 0;
-    const char* const* sdlExts = SDL_Vulkan_GetInstanceExtensions(&sdlExtCount);
-    if (!sdlExts)
-        throw std::runtime_error("Failed to get SDL Vulkan extensions");
-
-    std::vector<const char*> extensions(sdlExts, sdlExts + sdlExtCount);
+    std::vector<const char*> extensions;
+    if (!headless) {
+        uint32_t sdlExtCount = 0;
+        const char* const* sdlExts = SDL_Vulkan_GetInstanceExtensions(&sdlExtCount);
+        if (!sdlExts)
+            throw std::runtime_error("Failed to get SDL Vulkan extensions");
+        extensions.assign(sdlExts, sdlExts + sdlExtCount);
+    }
 
     VkInstanceCreateInfo instInfo{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
     instInfo.pApplicationInfo = &appInfo;
-    instInfo.enabledExtensionCount = sdlExtCount;
+    instInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     instInfo.ppEnabledExtensionNames = extensions.data();
 
     if (vkCreateInstance(&instInfo, nullptr, &instance) != VK_SUCCESS)
@@ -81,8 +139,9 @@ void GraphicsModule::pickPhysicalDevice() {
         vkGetPhysicalDeviceQueueFamilyProperties(dev, &queueFamilyCount, queueProps.data());
 
         for (uint32_t i = 0; i < queueFamilyCount; ++i) {
-            VkBool32 presentSupported = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupported);
+            VkBool32 presentSupported = headless;
+            if (!headless)
+                vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupported);
             if ((queueProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && presentSupported) {
                 physicalDevice = dev;
                 graphicsQueueFamilyIndex = i;
@@ -95,22 +154,101 @@ void GraphicsModule::pickPhysicalDevice() {
     if (physicalDevice == VK_NULL_HANDLE) {
         throw std::runtime_error("Failed to find a suitable physical device with graphics and presentation capabilities.");
     }
+
+    // Prefer a transfer-only family (DMA engine) for uploads, otherwise share the graphics queue
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueProps(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueProps.data());
+
+    transferQueueFamilyIndex = graphicsQueueFamilyIndex;
+    for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+        VkQueueFlags flags = queueProps[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            transferQueueFamilyIndex = i;
+            break;
+        }
+    }
 }
 
 void GraphicsModule::createLogicalDevice() {
     float queuePriority = 1.0f;
+    std::vector<VkDeviceQueueCreateInfo> queueInfos;
+
     VkDeviceQueueCreateInfo queueInfo{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
     queueInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
     queueInfo.queueCount = 1;
     queueInfo.pQueuePriorities = &queuePriority;
+    queueInfos.push_back(queueInfo);
 
-    const std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    if (transferQueueFamilyIndex != graphicsQueueFamilyIndex) {
+        queueInfo.queueFamilyIndex = transferQueueFamilyIndex;
+        queueInfos.push_back(queueInfo);
+    }
+
+    std::vector<const char*> deviceExtensions;
+    if (!headless)
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    // Present id + present wait let frame pacing and the latency readout see when an image
+    // actually reached the display
+    bool presentWaitExtensions = false;
+    if (!headless) {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+        bool presentId = false, presentWait = false;
+        for (const auto& extension : extensions) {
+            presentId |= std::strcmp(extension.extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0;
+            presentWait |= std::strcmp(extension.extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0;
+        }
+        presentWaitExtensions = presentId && presentWait;
+    }
+
+    VkPhysicalDeviceVulkan12Features supported12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    VkPhysicalDeviceVulkan13Features supported13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+    VkPhysicalDevicePresentIdFeaturesKHR supportedPresentId{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR supportedPresentWait{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    VkPhysicalDeviceFeatures2 supported{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    supported.pNext = &supported12;
+    supported12.pNext = &supported13;
+    if (presentWaitExtensions) {
+        supported13.pNext = &supportedPresentId;
+        supportedPresentId.pNext = &supportedPresentWait;
+    }
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+    drawIndirectCountSupported = supported12.drawIndirectCount == VK_TRUE;
+    if (supported13.dynamicRendering != VK_TRUE || supported13.synchronization2 != VK_TRUE)
+        throw std::runtime_error("Device lacks Vulkan 1.3 dynamic rendering or synchronization2");
+    presentWaitSupported = presentWaitExtensions && supportedPresentId.presentId == VK_TRUE &&
+                           supportedPresentWait.presentWait == VK_TRUE;
+
+    // Timeline semaphores track upload completion; indirect count drives GPU-culled draws
+    VkPhysicalDeviceVulkan12Features features12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    features12.timelineSemaphore = VK_TRUE;
+    features12.drawIndirectCount = supported12.drawIndirectCount;
+    // The main pass uses dynamic rendering, so there are no render pass or framebuffer
+    // objects; its barriers are synchronization2
+    VkPhysicalDeviceVulkan13Features features13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+    features13.dynamicRendering = VK_TRUE;
+    features13.synchronization2 = VK_TRUE;
+    features12.pNext = &features13;
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    if (presentWaitSupported) {
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        presentIdFeatures.presentId = VK_TRUE;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        features13.pNext = &presentIdFeatures;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+    }
 
     VkDeviceCreateInfo devInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-    devInfo.queueCreateInfoCount = 1;
-    devInfo.pQueueCreateInfos = &queueInfo;
+    devInfo.pNext = &features12;
+    devInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
+    devInfo.pQueueCreateInfos = queueInfos.data();
     devInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     devInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -118,9 +256,35 @@ void GraphicsModule::createLogicalDevice() {
         throw std::runtime_error("Failed to create logical device");
 
     vkGetDeviceQueue(device, graphicsQueueFamilyIndex, 0, &graphicsQueue);
+    vkGetDeviceQueue(device, transferQueueFamilyIndex, 0, &transferQueue);
+
+    if (presentWaitSupported) {
+        waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+        presentWaitSupported = waitForPresent != nullptr;
+    }
+}
+
+// Nearest supported mode to `wanted`; FIFO is always available
+static VkPresentModeKHR pickPresentMode(VkPresentModeKHR wanted, const std::vector<VkPresentModeKHR>& available) {
+    auto has = [&](VkPresentModeKHR mode) {
+        return std::find(available.begin(), available.end(), mode) != available.end();
+    };
+    if (has(wanted))
+        return wanted;
+    // Both present without waiting for vblank; MAILBOX just does not tear
+    if (wanted == VK_PRESENT_MODE_MAILBOX_KHR && has(VK_PRESENT_MODE_IMMEDIATE_KHR))
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if (wanted == VK_PRESENT_MODE_IMMEDIATE_KHR && has(VK_PRESENT_MODE_MAILBOX_KHR))
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 void GraphicsModule::createSwapchain() {
+    if (headless) {
+        createOffscreenImages();
+        return;
+    }
+
     VkSurfaceCapabilitiesKHR capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
 
@@ -140,17 +304,30 @@ void GraphicsModule::createSwapchain() {
 
     uint32_t presentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
-    std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, presentModes.data());
+    supportedPresentModes.resize(presentModeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, supportedPresentModes.data());
+    presentMode = pickPresentMode(requestedPresentMode, supportedPresentModes);
 
-    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR; // guaranteed available
+    uint32_t imageCount = requestedImageCount > 0 ? requestedImageCount : capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0)  // 0: no upper limit
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
 
     swapchainExtent = capabilities.currentExtent;
+    if (swapchainExtent.width == UINT32_MAX) {
+        // The surface size follows the swapchain (e.g. Wayland); take the window's size
+        int width = 0, height = 0;
+        SDL_GetWindowSizeInPixels(window, &width, &height);
+        swapchainExtent.width = std::clamp(static_cast<uint32_t>(width),
+                                           capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        swapchainExtent.height = std::clamp(static_cast<uint32_t>(height),
+                                            capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
     swapchainImageFormat = chosenFormat.format;
 
     VkSwapchainCreateInfoKHR swapchainInfo{ VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR };
     swapchainInfo.surface = surface;
-    swapchainInfo.minImageCount = capabilities.minImageCount + 1;
+    swapchainInfo.minImageCount = imageCount;
     swapchainInfo.imageFormat = swapchainImageFormat;
     swapchainInfo.imageColorSpace = chosenFormat.colorSpace;
     swapchainInfo.imageExtent = swapchainExtent;
@@ -161,17 +338,75 @@ void GraphicsModule::createSwapchain() {
     swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchainInfo.presentMode = presentMode;
     swapchainInfo.clipped = VK_TRUE;
-    swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
+    // On recreation, hand over the old swapchain so the presentation engine can reuse its
+    // resources and keep showing frames until the new one is ready
+    swapchainInfo.oldSwapchain = swapchain;
 
-    if (vkCreateSwapchainKHR(device, &swapchainInfo, nullptr, &swapchain) != VK_SUCCESS)
+    VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
+    if (vkCreateSwapchainKHR(device, &swapchainInfo, nullptr, &newSwapchain) != VK_SUCCESS)
         throw std::runtime_error("Failed to create swapchain");
+    swapchain = newSwapchain;
 
-    uint32_t imageCount = 0;
+    imageCount = 0;
     vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
     swapchainImages.resize(imageCount);
     vkGetSwapchainImagesKHR(device, swapchain, &imageCount, swapchainImages.data());
 }
 
+void GraphicsModule::createOffscreenImages() {
+    // One color target per frame in flight; the frame slot doubles as the image index
+    swapchainExtent = headlessExtent;
+    swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+    swapchainImages.resize(maxFramesInFlight);
+    offscreenAllocations.resize(maxFramesInFlight);
+    for (uint32_t i = 0; i < maxFramesInFlight; ++i) {
+        createImage(device, allocator, swapchainExtent.width, swapchainExtent.height, swapchainImageFormat,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    swapchainImages[i], offscreenAllocations[i]);
+    }
+}
+
+void GraphicsModule::destroySwapchainImages() {
+    if (headless) {
+        for (size_t i = 0; i < swapchainImages.size(); ++i)
+            destroyImage(device, allocator, swapchainImages[i], offscreenAllocations[i]);
+        offscreenAllocations.clear();
+    } else if (swapchain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, swapchain, nullptr);
+        swapchain = VK_NULL_HANDLE;
+    }
+    swapchainImages.clear();
+}
+
+void GraphicsModule::createDepthResources() {
+    if (depthFormat == VK_FORMAT_UNDEFINED) {
+        for (VkFormat candidate : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM }) {
+            VkFormatProperties props;
+            vkGetPhysicalDeviceFormatProperties(physicalDevice, candidate, &props);
+            if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+                depthFormat = candidate;
+                break;
+            }
+        }
+        if (depthFormat == VK_FORMAT_UNDEFINED)
+            throw std::runtime_error("Failed to find a supported depth format");
+    }
+
+    // Shared by all frames in flight; transitionAttachments orders the writes
+    createImage(device, allocator, swapchainExtent.width, swapchainExtent.height, depthFormat,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthImage, depthAllocation);
+    depthImageView = createImageView(device, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
+
+void GraphicsModule::destroyDepthResources() {
+    if (depthImageView != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, depthImageView, nullptr);
+        depthImageView = VK_NULL_HANDLE;
+    }
+    destroyImage(device, allocator, depthImage, depthAllocation);
+}
+
 void GraphicsModule::createImageViews() {
     swapchainImageViews.resize(swapchainImages.size());
     for (size_t i = 0; i < swapchainImages.size(); ++i) {
@@ -194,46 +429,6 @@ void GraphicsModule::createImageViews() {
     }
 }
 
-void GraphicsModule::createRenderPass() {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapchainImageFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create render pass");
-}
-
 void GraphicsModule::createCommandPoolAndBuffers() {
     VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
     poolInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
@@ -242,87 +437,421 @@ void GraphicsModule::createCommandPoolAndBuffers() {
     if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
         throw std::runtime_error("Failed to create command pool");
 
-    commandBuffers.resize(swapchainImageViews.size());
+    // One command buffer per frame in flight, independent of the swapchain image count
+    frames.resize(maxFramesInFlight);
+    std::vector<VkCommandBuffer> buffers(maxFramesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
     allocInfo.commandPool = commandPool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+    allocInfo.commandBufferCount = maxFramesInFlight;
 
-    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+    if (vkAllocateCommandBuffers(device, &allocInfo, buffers.data()) != VK_SUCCESS)
         throw std::runtime_error("Failed to allocate command buffers");
+
+    for (uint32_t i = 0; i < maxFramesInFlight; ++i)
+        frames[i].commandBuffer = buffers[i];
 }
 
-void GraphicsModule::createFramebuffers() {
-    swapchainFramebuffers.resize(swapchainImageViews.size());
+void GraphicsModule::createSyncObjects() {
+    VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // first wait on each slot must not block
 
-    for (size_t i = 0; i < swapchainImageViews.size(); ++i) {
-        VkImageView attachments[] = { swapchainImageViews[i] };
+    for (auto& frame : frames) {
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+            vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create frame synchronization objects");
+    }
+
+    createRenderFinishedSemaphores();
+}
+
+void GraphicsModule::createTimestampQueries() {
+    frameTimestamps = getTimestampProperties(physicalDevice, graphicsQueueFamilyIndex);
+    if (!frameTimestamps.supported())
+        return;  // frameStats.gpuFrameMs stays -1
 
-        VkFramebufferCreateInfo framebufferInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = swapchainExtent.width;
-        framebufferInfo.height = swapchainExtent.height;
-        framebufferInfo.layers = 1;
+    VkQueryPoolCreateInfo queryInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = 2 * maxFramesInFlight;
+    if (vkCreateQueryPool(device, &queryInfo, nullptr, &timestampPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timestamp query pool");
+}
+
+void GraphicsModule::readFrameTimestamps(FrameData& frame, uint32_t slot) {
+    // No reading for this frame must not repeat the last one as a new sample
+    frameStats.gpuFrameMs = -1.0;
+    if (!frame.timestampsPending)
+        return;
+    frame.timestampsPending = false;
+
+    // The slot's fence has been waited on, so the results are available without blocking
+    uint64_t ticks[2];
+    if (vkGetQueryPoolResults(device, timestampPool, 2 * slot, 2, sizeof(ticks), ticks, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+        frameStats.gpuFrameMs = static_cast<double>((ticks[1] - ticks[0]) & frameTimestamps.mask) *
+                                frameTimestamps.periodNs * 1e-6;
+}
+
+void GraphicsModule::createRenderFinishedSemaphores() {
+    VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+
+    renderFinishedSemaphores.resize(swapchainImages.size(), VK_NULL_HANDLE);
+    for (auto& semaphore : renderFinishedSemaphores) {
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create render-finished semaphore");
+    }
+
+    imagesInFlight.assign(swapchainImages.size(), VK_NULL_HANDLE);
+}
+
+void GraphicsModule::destroyRenderFinishedSemaphores() {
+    for (auto semaphore : renderFinishedSemaphores)
+        if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(device, semaphore, nullptr);
+    renderFinishedSemaphores.clear();
+    imagesInFlight.clear();
+}
 
-        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapchainFramebuffers[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create framebuffer");
+void GraphicsModule::transitionAttachments(VkCommandBuffer cmd, VkImage colorImage, bool toAttachment) {
+    VkImageMemoryBarrier2 barriers[2] = { { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 },
+                                          { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 } };
+    VkImageMemoryBarrier2& color = barriers[0];
+    color.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    color.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    color.image = colorImage;
+    color.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    VkImageLayout finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    if (!toAttachment) {
+        // Presentation (or a headless readback) is ordered by the semaphore or fence
+        color.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        color.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        color.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        color.newLayout = finalLayout;
+        VkDependencyInfo dependency{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dependency.imageMemoryBarrierCount = 1;
+        dependency.pImageMemoryBarriers = barriers;
+        vkCmdPipelineBarrier2(cmd, &dependency);
+        return;
     }
+
+    // Same stage as the image-available semaphore wait, so the transition runs after it
+    color.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    color.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    color.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+    color.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    // The depth image is shared between frames in flight: order this frame's clear after
+    // the previous frame's depth writes
+    VkImageMemoryBarrier2& depth = barriers[1];
+    depth.srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+    depth.srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depth.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+    depth.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depth.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depth.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depth.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depth.image = depthImage;
+    VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (depthFormat == VK_FORMAT_D24_UNORM_S8_UINT)
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    depth.subresourceRange = { depthAspect, 0, 1, 0, 1 };
+
+    VkDependencyInfo dependency{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dependency.imageMemoryBarrierCount = 2;
+    dependency.pImageMemoryBarriers = barriers;
+    vkCmdPipelineBarrier2(cmd, &dependency);
 }
 
 void GraphicsModule::beginFrame() {
     // SDL_PumpEvents(); // SDL_PollEvent in pollEvents() is generally preferred for explicit event handling
 }
 
-void GraphicsModule::draw(std::function<void(VkCommandBuffer)> renderCallback) {
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, VK_NULL_HANDLE, VK_NULL_HANDLE, &imageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        m_framebufferResized = true;
+void GraphicsModule::setPresentMode(VkPresentModeKHR mode) {
+    if (mode == requestedPresentMode)
         return;
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("Failed to acquire swapchain image!");
+    requestedPresentMode = mode;
+    if (swapchain != VK_NULL_HANDLE && pickPresentMode(mode, supportedPresentModes) != presentMode)
+        m_framebufferResized = true;  // recreated in handleResizeIfNeeded
+}
+
+bool GraphicsModule::isPresentModeSupported(VkPresentModeKHR mode) const {
+    return std::find(supportedPresentModes.begin(), supportedPresentModes.end(), mode) != supportedPresentModes.end();
+}
+
+void GraphicsModule::setSwapchainImageCount(uint32_t count) {
+    if (count == requestedImageCount)
+        return;
+    requestedImageCount = count;
+    if (swapchain != VK_NULL_HANDLE)
+        m_framebufferResized = true;
+}
+
+void GraphicsModule::waitForFrame() {
+    using Clock = std::chrono::steady_clock;
+    TraceScope trace("Frame pacing", "frame");
+    auto waitStart = Clock::now();
+
+    // Frame rate limit: sleep before input is read, not after the frame was drawn with it
+    if (frameRateLimit > 0.0f) {
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRateLimit));
+        auto now = Clock::now();
+        if (now < nextFrameDue) {
+            SDL_DelayNS(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(nextFrameDue - now).count()));
+            now = nextFrameDue;
+        }
+        // After a late frame the schedule restarts rather than catching up with a burst
+        nextFrameDue = (now - nextFrameDue < interval ? nextFrameDue : now) + interval;
     }
 
-    VkCommandBuffer cmd = commandBuffers[imageIndex];
+    // Low latency: nothing is queued behind the display, so the next frame's input is at
+    // most one frame old when it is shown. Bounded, as a hidden window may never present.
+    const uint64_t timeoutNs = 100'000'000;
+    if (lowLatency && !headless) {
+        if (presentWaitSupported && lastPresentId > 0) {
+            if (waitForPresent(device, swapchain, lastPresentId, timeoutNs) == VK_ERROR_OUT_OF_DATE_KHR)
+                m_framebufferResized = true;
+        } else if (!presentWaitSupported) {
+            // The GPU finishing the previous frame is the closest signal there is
+            const FrameData& previous = frames[(currentFrame + maxFramesInFlight - 1) % maxFramesInFlight];
+            vkWaitForFences(device, 1, &previous.inFlightFence, VK_TRUE, timeoutNs);
+        }
+    }
+    collectPresents();
+
+    frameStats.paceWaitMs = std::chrono::duration<double, std::milli>(Clock::now() - waitStart).count();
+}
+
+void GraphicsModule::collectPresents() {
+    while (presentWaitSupported && !latencyProbes.empty()) {
+        if (waitForPresent(device, swapchain, latencyProbes.front().presentId, 0) != VK_SUCCESS)
+            return;
+        recordInputLatency(latencyProbes.front().inputNs);
+        latencyProbes.pop_front();
+    }
+}
+
+void GraphicsModule::recordInputLatency(uint64_t inputNs) {
+    uint64_t now = SDL_GetTicksNS();
+    double ms = now > inputNs ? (now - inputNs) / 1e6 : 0.0;
+    frameStats.inputLatencyMs = ms;
+    frameStats.avgInputLatencyMs = frameStats.avgInputLatencyMs < 0.0 ? ms : frameStats.avgInputLatencyMs * 0.9 + ms * 0.1;
+    frameStats.latencyToDisplay = presentWaitSupported;
+}
+
+void GraphicsModule::draw(std::function<void(VkCommandBuffer)> renderCallback) {
+    drawFrame(&renderCallback, nullptr);
+}
+
+void GraphicsModule::drawTasks(const std::vector<RenderTask>& tasks) {
+    drawFrame(nullptr, &tasks);
+}
+
+void GraphicsModule::setRecordThreads(uint32_t workers) {
+    recordWorkers = workers;
+    if (device != VK_NULL_HANDLE)
+        recorder.setWorkerCount(workers);
+}
+
+void GraphicsModule::drawFrame(const std::function<void(VkCommandBuffer)>* renderCallback,
+                               const std::vector<RenderTask>* tasks) {
+    using Clock = std::chrono::steady_clock;
+    FrameData& frame = frames[currentFrame];
+
+    // Block only until the GPU has finished the frame that last used this slot
+    auto waitStart = Clock::now();
+    vkWaitForFences(device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+    readFrameTimestamps(frame, currentFrame);
+    if (!headless)
+        collectPresents();
+    profiler.collectGpu(currentFrame);
+
+    uint32_t imageIndex = currentFrame;
+    VkResult result = VK_SUCCESS;
+    if (!headless) {
+        result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            m_framebufferResized = true;
+            return;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("Failed to acquire swapchain image!");
+        }
+    }
+
+    // The image may still be in use by an older frame slot if images are acquired out of order
+    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE && imagesInFlight[imageIndex] != frame.inFlightFence)
+        vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    imagesInFlight[imageIndex] = frame.inFlightFence;
+
+    // Input read up to now is what this frame shows
+    uint64_t inputNs = pendingInputNs;
+    pendingInputNs = 0;
+
+    double waitMs = std::chrono::duration<double, std::milli>(Clock::now() - waitStart).count();
+    frameStats.gpuWaitMs = waitMs;
+    frameStats.avgGpuWaitMs = frameStats.frameIndex == 0 ? waitMs : frameStats.avgGpuWaitMs * 0.95 + waitMs * 0.05;
+    frameStats.frameIndex++;
+
+    runDeferredDestroys(false);
+    instanceBuffer.sync(currentFrame);
+
+    vkResetFences(device, 1, &frame.inFlightFence);
+
+    // Kick off this frame's uploads so the copies overlap with recording
+    uploader.flush();
+
+    CpuScope recordScope(profiler, CpuPhase::Record);
+    VkCommandBuffer cmd = frame.commandBuffer;
+    vkResetCommandBuffer(cmd, 0);
+
     VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(cmd, &beginInfo);
 
-    VkClearValue clearColor = { {0.0f, 0.0f, 1.0f, 1.0f} };
+    if (timestampPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(cmd, timestampPool, 2 * currentFrame, 2);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 2 * currentFrame);
+    }
+    profiler.resetGpu(cmd, currentFrame);
 
-    VkRenderPassBeginInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-    renderPassInfo.renderPass = renderPass;
-    renderPassInfo.framebuffer = swapchainFramebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = swapchainExtent;
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
+    uploader.recordAcquireBarriers(cmd);
+    recordCulling(cmd);
+    prepareScene();
 
-    vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Dynamic rendering: the attachments are named per frame, so nothing but the image
+    // views depends on the swapchain and pipelines only know the attachment formats
+    transitionAttachments(cmd, swapchainImages[imageIndex], true);
 
-    if (renderCallback) {
-        renderCallback(cmd);
+    VkRenderingAttachmentInfo colorAttachment{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+    colorAttachment.imageView = swapchainImageViews[imageIndex];
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue.color = { {0.0f, 0.0f, 1.0f, 1.0f} };
+
+    VkRenderingAttachmentInfo depthAttachment{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+    depthAttachment.imageView = depthImageView;
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+    VkRenderingInfo renderingInfo{ VK_STRUCTURE_TYPE_RENDERING_INFO };
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = swapchainExtent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+
+    if (tasks) {
+        // The pass contents are secondaries; the primary only executes them, in task order
+        recorder.record(currentFrame, swapchainImageFormat, depthFormat, swapchainExtent, *tasks, secondaryBuffers);
+        frameStats.reusedTasks = recorder.getReusedCount();
+        renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+        vkCmdBeginRendering(cmd, &renderingInfo);
+        if (!secondaryBuffers.empty())
+            vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
+    } else {
+        frameStats.reusedTasks = 0;
+        vkCmdBeginRendering(cmd, &renderingInfo);
+
+        VkViewport viewport{ 0.0f, 0.0f, (float)swapchainExtent.width, (float)swapchainExtent.height, 0.0f, 1.0f };
+        VkRect2D scissor{ {0, 0}, swapchainExtent };
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+        if (renderCallback && *renderCallback) {
+            (*renderCallback)(cmd);
+        }
     }
 
-    vkCmdEndRenderPass(cmd);
+    vkCmdEndRendering(cmd);
+    transitionAttachments(cmd, swapchainImages[imageIndex], false);
+    if (timestampPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2 * currentFrame + 1);
+        frame.timestampsPending = true;
+    }
     vkEndCommandBuffer(cmd);
+    recordScope.stop();
+
+    VkSemaphore renderFinished = renderFinishedSemaphores[imageIndex];
+
+    // Binary wait for the swapchain image, plus a timeline wait for uploads used by this frame
+    VkSemaphore waitSemaphores[2] = {};
+    VkPipelineStageFlags waitStages[2] = {};
+    uint64_t waitValues[2] = { 0, 0 };
+    uint32_t waitCount = 0;
+    if (!headless) {
+        waitSemaphores[waitCount] = frame.imageAvailable;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        waitCount++;
+    }
+    if (uploader.takeGraphicsWait(waitSemaphores[waitCount], waitValues[waitCount], waitStages[waitCount]))
+        waitCount++;
+    uint64_t signalValue = 0;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = headless ? 0 : 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
 
     VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = headless ? 0 : 1;
+    submitInfo.pSignalSemaphores = &renderFinished;
 
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
+    {
+        CpuScope submitScope(profiler, CpuPhase::Submit);
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS)
+            throw std::runtime_error("Failed to submit draw command buffer!");
+    }
+    submittedFrames++;
+
+    if (headless) {
+        currentFrame = (currentFrame + 1) % maxFramesInFlight;
+        profiler.endFrame();
+        return;
+    }
 
     VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &renderFinished;
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapchain;
     presentInfo.pImageIndices = &imageIndex;
+    uint64_t presentId = lastPresentId + 1;
+    VkPresentIdKHR presentIdInfo{ VK_STRUCTURE_TYPE_PRESENT_ID_KHR };
+    if (presentWaitSupported) {
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds = &presentId;
+        presentInfo.pNext = &presentIdInfo;
+    }
+
+    currentFrame = (currentFrame + 1) % maxFramesInFlight;
 
-    result = vkQueuePresentKHR(graphicsQueue, &presentInfo);
+    {
+        CpuScope presentScope(profiler, CpuPhase::Present);
+        result = vkQueuePresentKHR(graphicsQueue, &presentInfo);
+    }
+    // Input latency is known once the present completes, or taken here without present wait
+    if (presentWaitSupported) {
+        lastPresentId = presentId;
+        if (inputNs != 0)
+            latencyProbes.push_back({ presentId, inputNs });
+    } else if (inputNs != 0) {
+        recordInputLatency(inputNs);
+    }
+    profiler.endFrame();
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         m_framebufferResized = true;
         return;
@@ -338,16 +867,53 @@ void GraphicsModule::cleanup() {
         vkDeviceWaitIdle(device);
     }
 
-    for (auto framebuffer : swapchainFramebuffers)
-        if (framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(device, framebuffer, nullptr);
+    destroySphereBuffers();
+    runDeferredDestroys(true);
+    culler.cleanup();
+    instanceBuffer.cleanup();
+    destroyCameraBuffers();
+
+    for (uint32_t i = 0; i < VertexFormatCount; ++i) {
+        if (graphicsPipelines[i] != VK_NULL_HANDLE)
+            vkDestroyPipeline(device, graphicsPipelines[i], nullptr);
+        if (instancedPipelines[i] != VK_NULL_HANDLE)
+            vkDestroyPipeline(device, instancedPipelines[i], nullptr);
+    }
+    if (proceduralPipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, proceduralPipeline, nullptr);
+    if (proceduralInstancedPipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, proceduralInstancedPipeline, nullptr);
+    if (impostorPipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, impostorPipeline, nullptr);
+    if (pipelineLayout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    if (instancedPipelineLayout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(device, instancedPipelineLayout, nullptr);
+    if (impostorPipelineLayout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(device, impostorPipelineLayout, nullptr);
+    pipelineCache.save();
+    pipelineCache.cleanup();
+
+    destroyRenderFinishedSemaphores();
+    for (auto& frame : frames) {
+        if (frame.imageAvailable != VK_NULL_HANDLE) vkDestroySemaphore(device, frame.imageAvailable, nullptr);
+        if (frame.inFlightFence != VK_NULL_HANDLE) vkDestroyFence(device, frame.inFlightFence, nullptr);
+    }
+    frames.clear();
+    if (timestampPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device, timestampPool, nullptr);
+    profiler.cleanup();
+    recorder.cleanup();
     if (commandPool != VK_NULL_HANDLE)
         vkDestroyCommandPool(device, commandPool, nullptr);
     for (auto view : swapchainImageViews)
         if (view != VK_NULL_HANDLE) vkDestroyImageView(device, view, nullptr);
-    if (swapchain != VK_NULL_HANDLE)
-        vkDestroySwapchainKHR(device, swapchain, nullptr);
-    if (renderPass != VK_NULL_HANDLE)
-        vkDestroyRenderPass(device, renderPass, nullptr);
+    destroyDepthResources();
+    destroySwapchainImages();
+
+    uploader.cleanup();
+    allocator.cleanup();
+
     if (device != VK_NULL_HANDLE)
         vkDestroyDevice(device, nullptr);
     if (surface != VK_NULL_HANDLE)
@@ -360,9 +926,30 @@ void GraphicsModule::cleanup() {
     SDL_Quit();
 }
 
-void GraphicsModule::pollEvents() {
+void GraphicsModule::waitEvents(int32_t timeoutMs) {
+    if (!window || timeoutMs == 0)
+        return;
+    if (timeoutMs < 0)
+        SDL_WaitEvent(nullptr);
+    else
+        SDL_WaitEventTimeout(nullptr, timeoutMs);
+}
+
+bool GraphicsModule::pollEvents() {
+    if (!window)
+        return false;
+
     SDL_Event event;
+    bool input = false;
     while (SDL_PollEvent(&event)) {
+        if (event.type >= SDL_EVENT_USER)
+            continue; // wake-ups, e.g. RedrawScheduler::requestRedraw
+        input = true;
+        bool userInput = event.type == SDL_EVENT_MOUSE_MOTION || event.type == SDL_EVENT_MOUSE_WHEEL ||
+                         event.type == SDL_EVENT_MOUSE_BUTTON_DOWN || event.type == SDL_EVENT_MOUSE_BUTTON_UP ||
+                         event.type == SDL_EVENT_KEY_DOWN || event.type == SDL_EVENT_KEY_UP;
+        if (userInput && pendingInputNs == 0)
+            pendingInputNs = event.common.timestamp;
         ImGui_ImplSDL3_ProcessEvent(&event); // Forward to ImGui
 
         switch (event.type) {
@@ -408,32 +995,58 @@ void GraphicsModule::pollEvents() {
                 switch (event.key.key) {
                 case SDLK_Q: camera.roll(0.05f); break;
                 case SDLK_E: camera.roll(-0.05f); break;
+                case SDLK_F9: Tracer::get().toggle(); break;
                 }
             }
             break;
         }
     }
+    return input;
 }
 
 
 void GraphicsModule::recreateSwapchain() {
-    vkDeviceWaitIdle(device);
-
-    for (auto framebuffer : swapchainFramebuffers)
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    for (auto view : swapchainImageViews)
-        vkDestroyImageView(device, view, nullptr);
-    if (swapchain)
-        vkDestroySwapchainKHR(device, swapchain, nullptr);
-
-    createSwapchain();
+    // No device stall: frames still in flight keep using the old swapchain's views, depth
+    // image and semaphores, so those are retired through the deferred
+    // destroy queue while the new set is built alongside them.
+    VkSwapchainKHR oldSwapchain = swapchain;
+    std::vector<VkImageView> oldViews = std::move(swapchainImageViews);
+    std::vector<VkSemaphore> oldRenderFinished = std::move(renderFinishedSemaphores);
+    VkImage oldDepthImage = depthImage;
+    GpuAllocation oldDepthAllocation = depthAllocation;
+    VkImageView oldDepthView = depthImageView;
+    swapchainImageViews.clear();
+    renderFinishedSemaphores.clear();
+    depthImage = VK_NULL_HANDLE;
+    depthAllocation = {};
+    depthImageView = VK_NULL_HANDLE;
+
+    createSwapchain();  // passes oldSwapchain, which is retired from here on
+    swapchainGeneration++;
+    // Present ids are per swapchain; frames still queued on the old one go unmeasured
+    lastPresentId = 0;
+    latencyProbes.clear();
     createImageViews();
-    createFramebuffers();
+    createDepthResources();
+    createRenderFinishedSemaphores();
+
+    // Presents are not fenced, so the old render-finished semaphores are only known to be
+    // free once the frames queued after the last old present have completed
+    deferDestroy([this, oldSwapchain, oldViews, oldRenderFinished,
+                  oldDepthImage, oldDepthAllocation, oldDepthView]() mutable {
+        for (auto view : oldViews)
+            vkDestroyImageView(device, view, nullptr);
+        for (auto semaphore : oldRenderFinished)
+            vkDestroySemaphore(device, semaphore, nullptr);
+        vkDestroyImageView(device, oldDepthView, nullptr);
+        destroyImage(device, allocator, oldDepthImage, oldDepthAllocation);
+        vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+    });
 }
 
 
 void GraphicsModule::handleResizeIfNeeded() {
-    if (!m_framebufferResized) return;
+    if (!m_framebufferResized || !window) return;
 
     // Wait until window has non-zero size
     int width = 0, height = 0;
@@ -465,41 +1078,80 @@ void GraphicsModule::acknowledgeResize() {
 }
 
 void GraphicsModule::createGraphicsPipeline() {
-    auto readFile = [](const std::string& path) -> std::vector<char> {
-        std::ifstream file(path, std::ios::binary | std::ios::ate);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open file: " + path);
-
-        size_t size = (size_t)file.tellg();
-        if (size == static_cast<size_t>(-1))
-            throw std::runtime_error("Failed to get file size: " + path);
-
-        std::vector<char> buffer(size);
-        file.seekg(0);
-        file.read(buffer.data(), size);
-        return buffer;
-    };
+    VkPushConstantRange pushConstant{};
+    pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstant.offset = 0;
+    pushConstant.size = sizeof(PushConstants);
 
-    std::string shaderPath = SHADER_PATH;
-    auto vertShaderCode = readFile(shaderPath + "sphere.vert.spv");
-    auto fragShaderCode = readFile(shaderPath + "sphere.frag.spv");
+    // Every sphere layout shares set 0 (instances, unused by the single sphere) and set 1
+    // (camera), so the same shaders' camera block fits all of them
+    VkDescriptorSetLayout setLayouts[2] = { instanceBuffer.getDescriptorSetLayout(), cameraSetLayout };
 
-    VkShaderModuleCreateInfo createInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-    createInfo.codeSize = vertShaderCode.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(vertShaderCode.data());
-    VkShaderModule vertModule;
-    vkCreateShaderModule(device, &createInfo, nullptr, &vertModule);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
+
+    vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+
+    // Instanced variant: per-instance data in set 0, the packed position scale in push constants
+    VkPushConstantRange instancedPushConstant{};
+    instancedPushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    instancedPushConstant.offset = 0;
+    instancedPushConstant.size = sizeof(InstancedPushConstants);
 
-    createInfo.codeSize = fragShaderCode.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(fragShaderCode.data());
-    VkShaderModule fragModule;
-    vkCreateShaderModule(device, &createInfo, nullptr, &fragModule);
+    VkPipelineLayoutCreateInfo instancedLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    instancedLayoutInfo.setLayoutCount = 2;
+    instancedLayoutInfo.pSetLayouts = setLayouts;
+    instancedLayoutInfo.pushConstantRangeCount = 1;
+    instancedLayoutInfo.pPushConstantRanges = &instancedPushConstant;
+
+    vkCreatePipelineLayout(device, &instancedLayoutInfo, nullptr, &instancedPipelineLayout);
+
+    for (uint32_t i = 0; i < VertexFormatCount; ++i) {
+        VertexFormat format = static_cast<VertexFormat>(i);
+        graphicsPipelines[i] = createSpherePipeline("sphere.vert.spv", pipelineLayout, format);
+        instancedPipelines[i] = createSpherePipeline("sphere_instanced.vert.spv", instancedPipelineLayout, format);
+    }
+    proceduralPipeline = createSpherePipeline("sphere_procedural.vert.spv", pipelineLayout,
+                                              VertexFormat::Float32, true);
+    proceduralInstancedPipeline = createSpherePipeline("sphere_procedural_instanced.vert.spv", instancedPipelineLayout,
+                                                       VertexFormat::Float32, true);
+
+    // Impostors: instances in set 0, and everything else comes from the camera
+    VkPipelineLayoutCreateInfo impostorLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    impostorLayoutInfo.setLayoutCount = 2;
+    impostorLayoutInfo.pSetLayouts = setLayouts;
+
+    vkCreatePipelineLayout(device, &impostorLayoutInfo, nullptr, &impostorPipelineLayout);
+    // A quad has no far side to fall back on, so it must not be culled whichever way it winds
+    impostorPipeline = createSpherePipeline("sphere_impostor.vert.spv", impostorPipelineLayout,
+                                            VertexFormat::Float32, true, "sphere_impostor.frag.spv",
+                                            VK_CULL_MODE_NONE);
+}
+
+VkPipeline GraphicsModule::createSpherePipeline(const std::string& vertShader, VkPipelineLayout layout,
+                                                VertexFormat format, bool procedural, const std::string& fragShader,
+                                                VkCullModeFlags cullMode) {
+    VkShaderModule vertModule = loadShaderModule(device, vertShader);
+    VkShaderModule fragModule = loadShaderModule(device, fragShader);
 
     VkPipelineShaderStageCreateInfo vertStage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
     vertStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
     vertStage.module = vertModule;
     vertStage.pName = "main";
 
+    // constant_id 0 = PackedNormals
+    VkBool32 packedNormals = format == VertexFormat::Packed ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry specEntry{ 0, 0, sizeof(VkBool32) };
+    VkSpecializationInfo specInfo{};
+    specInfo.mapEntryCount = 1;
+    specInfo.pMapEntries = &specEntry;
+    specInfo.dataSize = sizeof(packedNormals);
+    specInfo.pData = &packedNormals;
+    vertStage.pSpecializationInfo = &specInfo;
+
     VkPipelineShaderStageCreateInfo fragStage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
     fragStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     fragStage.module = fragModule;
@@ -507,31 +1159,35 @@ void GraphicsModule::createGraphicsPipeline() {
 
     VkPipelineShaderStageCreateInfo shaderStages[] = { vertStage, fragStage };
 
-    auto binding = GeomCreate::getBindingDescription();
-    auto attributes = GeomCreate::getAttributeDescriptions();
+    auto binding = GeomCreate::getBindingDescription(format);
+    auto attributes = GeomCreate::getAttributeDescriptions(format);
 
     VkPipelineVertexInputStateCreateInfo vertexInput{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
-    vertexInput.vertexBindingDescriptionCount = 1;
-    vertexInput.pVertexBindingDescriptions = &binding;
-    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
-    vertexInput.pVertexAttributeDescriptions = attributes.data();
+    if (!procedural) {
+        vertexInput.vertexBindingDescriptionCount = 1;
+        vertexInput.pVertexBindingDescriptions = &binding;
+        vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+        vertexInput.pVertexAttributeDescriptions = attributes.data();
+    }
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport{ 0.0f, 0.0f, (float)swapchainExtent.width, (float)swapchainExtent.height, 0.0f, 1.0f };
-    VkRect2D scissor{ {0, 0}, swapchainExtent };
+    // Viewport and scissor are set per frame in draw(), so the pipeline outlives resizes
     VkPipelineViewportStateCreateInfo viewportState{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
 
     VkPipelineRasterizationStateCreateInfo rasterizer{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
     rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
     rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.cullMode = cullMode;
     rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
     VkPipelineMultisampleStateCreateInfo multisampling{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
@@ -546,16 +1202,10 @@ void GraphicsModule::createGraphicsPipeline() {
     colorBlending.attachmentCount = 1;
     colorBlending.pAttachments = &colorBlendAttachment;
 
-    VkPushConstantRange pushConstant{};
-    pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstant.offset = 0;
-    pushConstant.size = sizeof(PushConstants);
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
-
-    vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    VkPipelineDepthStencilStateCreateInfo depthStencil{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
 
     VkGraphicsPipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
     pipelineInfo.stageCount = 2;
@@ -565,45 +1215,313 @@ void GraphicsModule::createGraphicsPipeline() {
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = layout;
+
+    // No render pass: the pipeline draws into any pass with these attachment formats
+    VkPipelineRenderingCreateInfo renderingInfo{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &swapchainImageFormat;
+    renderingInfo.depthAttachmentFormat = depthFormat;
+    pipelineInfo.pNext = &renderingInfo;
 
-    vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    vkCreateGraphicsPipelines(device, pipelineCache.get(), 1, &pipelineInfo, nullptr, &pipeline);
 
     vkDestroyShaderModule(device, fragModule, nullptr);
     vkDestroyShaderModule(device, vertModule, nullptr);
+    return pipeline;
 }
 
 void GraphicsModule::drawSphere(VkCommandBuffer cmd) {
+    if (proceduralSphere.enabled) {
+        drawProceduralSphere(cmd);
+        return;
+    }
+    if (!sphereMesh.valid())
+        return; // first mesh still being built
+    GpuScope gpuScope(profiler, cmd, GpuPhase::SpherePass);
+
     VkDeviceSize offsets[] = { 0 };
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer, offsets);
-    vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindVertexBuffers(cmd, 0, 1, &sphereMesh.vertexBuffer, offsets);
+    vkCmdBindIndexBuffer(cmd, sphereMesh.indexBuffer, 0, sphereMesh.indexType);
+
+    uint32_t formatIndex = static_cast<uint32_t>(sphereMesh.vertexFormat);
+    uint32_t instanceCount = instanceBuffer.getCount();
+    if (instanceCount > 0) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelines[formatIndex]);
+        bindCamera(cmd, instancedPipelineLayout);
+
+        InstancedPushConstants pc{};
+        pc.positionScale = sphereMesh.positionScale;
+        vkCmdPushConstants(cmd, instancedPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(InstancedPushConstants), &pc);
+
+        if (culledThisFrame) {
+            culler.draw(cmd, currentFrame, instancedPipelineLayout);
+            drawImpostors(cmd);
+        } else {
+            VkDescriptorSet instanceSet = instanceBuffer.getDescriptorSet(currentFrame);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+                                    0, 1, &instanceSet, 0, nullptr);
+            const MeshLod& finest = sphereMesh.lods[sphereMesh.lodCount - 1];
+            vkCmdDrawIndexed(cmd, finest.indexCount, instanceCount, finest.firstIndex, 0, 0);
+        }
+        return;
+    }
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelines[formatIndex]);
+    bindCamera(cmd, pipelineLayout);
 
-    glm::mat4 view = camera.getViewMatrix();
-    glm::mat4 proj = camera.getProjectionMatrix();
     PushConstants pc;
-    pc.model = glm::mat4(1.0f); // Identity for now
-    pc.mvp = proj * view * pc.model;
+    // Identity for now; the packed position scale rides along (uniform, so normals stay valid)
+    pc.model = glm::scale(glm::mat4(1.0f), glm::vec3(sphereMesh.positionScale));
     vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &pc);
 
-    vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
+    // Picked in prepareScene
+    const MeshLod& lod = sphereMesh.lods[sphereLod];
+    vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.firstIndex, 0, 0);
 }
 
-void GraphicsModule::destroySphereBuffers() {
-    if (vertexBuffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device, vertexBuffer, nullptr);
-        vkFreeMemory(device, vertexMemory, nullptr);
-        vertexBuffer = VK_NULL_HANDLE;
-        vertexMemory = VK_NULL_HANDLE;
+void GraphicsModule::drawSphereInstances(VkCommandBuffer cmd, uint32_t firstInstance, uint32_t count) {
+    uint32_t instanceCount = instanceBuffer.getCount();
+    if (firstInstance >= instanceCount)
+        return;
+    count = std::min(count, instanceCount - firstInstance);
+    // No GpuScope: batches would write the same timestamp query more than once
+
+    VkDescriptorSet instanceSet = instanceBuffer.getDescriptorSet(currentFrame);
+    if (proceduralSphere.enabled) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, proceduralInstancedPipeline);
+        bindCamera(cmd, instancedPipelineLayout);
+        ProceduralPushConstants pc = GeomCreate::proceduralPushConstants(proceduralSphere);
+        vkCmdPushConstants(cmd, instancedPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ProceduralPushConstants), &pc);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+                                0, 1, &instanceSet, 0, nullptr);
+        vkCmdDraw(cmd, GeomCreate::proceduralVertexCount(proceduralSphere), count, 0, firstInstance);
+        return;
+    }
+    if (!sphereMesh.valid())
+        return;
+
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(cmd, 0, 1, &sphereMesh.vertexBuffer, offsets);
+    vkCmdBindIndexBuffer(cmd, sphereMesh.indexBuffer, 0, sphereMesh.indexType);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      instancedPipelines[static_cast<uint32_t>(sphereMesh.vertexFormat)]);
+    bindCamera(cmd, instancedPipelineLayout);
+
+    InstancedPushConstants pc{};
+    pc.positionScale = sphereMesh.positionScale;
+    vkCmdPushConstants(cmd, instancedPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(InstancedPushConstants), &pc);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+                            0, 1, &instanceSet, 0, nullptr);
+    const MeshLod& finest = sphereMesh.lods[sphereMesh.lodCount - 1];
+    vkCmdDrawIndexed(cmd, finest.indexCount, count, finest.firstIndex, 0, firstInstance);
+}
+
+void GraphicsModule::drawProceduralSphere(VkCommandBuffer cmd) {
+    GpuScope gpuScope(profiler, cmd, GpuPhase::SpherePass);
+
+    ProceduralPushConstants pc = GeomCreate::proceduralPushConstants(proceduralSphere);
+    uint32_t vertexCount = GeomCreate::proceduralVertexCount(proceduralSphere);
+    uint32_t instanceCount = instanceBuffer.getCount();
+    if (instanceCount > 0) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, proceduralInstancedPipeline);
+        bindCamera(cmd, instancedPipelineLayout);
+        vkCmdPushConstants(cmd, instancedPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ProceduralPushConstants), &pc);
+        if (culledThisFrame) {
+            culler.draw(cmd, currentFrame, instancedPipelineLayout, false);
+            drawImpostors(cmd);
+        } else {
+            VkDescriptorSet instanceSet = instanceBuffer.getDescriptorSet(currentFrame);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+                                    0, 1, &instanceSet, 0, nullptr);
+            vkCmdDraw(cmd, vertexCount, instanceCount, 0, 0);
+        }
+        return;
+    }
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, proceduralPipeline);
+    bindCamera(cmd, pipelineLayout);
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ProceduralPushConstants), &pc);
+    vkCmdDraw(cmd, vertexCount, 1, 0, 0);
+}
+
+void GraphicsModule::drawImpostors(VkCommandBuffer cmd) {
+    if (impostorDistance <= 0.0f)
+        return;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, impostorPipeline);
+    bindCamera(cmd, impostorPipelineLayout);
+    culler.drawImpostors(cmd, currentFrame, impostorPipelineLayout);
+}
+
+float GraphicsModule::pixelsPerUnit() const {
+    return std::abs(camera.getProjectionMatrix()[1][1]) * static_cast<float>(swapchainExtent.height) * 0.5f;
+}
+
+void GraphicsModule::recordCulling(VkCommandBuffer cmd) {
+    uint32_t instanceCount = instanceBuffer.getCount();
+    bool procedural = proceduralSphere.enabled;
+    culledThisFrame = gpuCulling && instanceCount > 0 && (procedural || sphereMesh.valid());
+    if (!culledThisFrame)
+        return;
+
+    GpuScope gpuScope(profiler, cmd, GpuPhase::Culling);
+    glm::vec4 planes[6];
+    camera.getFrustumPlanes(planes);
+    FrustumCuller::LodParams lod;
+    lod.cameraPosition = glm::vec3(glm::inverse(camera.getViewMatrix())[3]);
+    lod.pixelsPerUnit = pixelsPerUnit();
+    lod.pixelError = lodPixelError;
+    lod.impostorDistance = impostorDistance;
+    // The procedural sphere culls as a one-level unit-sphere mesh whose "indices" are its vertices
+    GpuMesh proceduralMesh;
+    if (procedural) {
+        proceduralMesh.indexCount = GeomCreate::proceduralVertexCount(proceduralSphere);
+        proceduralMesh.lods[0].indexCount = proceduralMesh.indexCount;
+        proceduralMesh.lodCount = 1;
+    }
+    culler.record(cmd, currentFrame, instanceBuffer.getBuffer(currentFrame), instanceCount,
+                  planes, procedural ? proceduralMesh : sphereMesh, lod);
+}
+
+void GraphicsModule::prepareScene() {
+    FrameData& frame = frames[currentFrame];
+    if (frame.cameraVersion != camera.getVersion()) {
+        CameraUniforms uniforms;
+        uniforms.view = camera.getViewMatrix();
+        uniforms.proj = camera.getProjectionMatrix();
+        uniforms.viewProj = uniforms.proj * uniforms.view;
+        memcpy(frame.cameraAllocation.mapped, &uniforms, sizeof(uniforms));
+        frame.cameraVersion = camera.getVersion();
+    }
+
+    // The single sphere's level is chosen here rather than while recording, so a camera move
+    // only invalidates recorded commands when the level actually changes
+    if (!proceduralSphere.enabled && sphereMesh.valid() && instanceBuffer.getCount() == 0) {
+        // The sphere sits at the origin in mesh units, so its distance is the camera's
+        float distance = glm::length(glm::vec3(glm::inverse(camera.getViewMatrix())[3]));
+        sphereLod = selectMeshLod(sphereMesh, distance, pixelsPerUnit(), lodPixelError, sphereLod);
     }
 
-    if (indexBuffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device, indexBuffer, nullptr);
-        vkFreeMemory(device, indexMemory, nullptr);
-        indexBuffer = VK_NULL_HANDLE;
-        indexMemory = VK_NULL_HANDLE;
+    SceneKey key;
+    key.meshGeneration = meshGeneration;
+    key.swapchainGeneration = swapchainGeneration;
+    key.instanceSetVersion = instanceBuffer.getSetVersion();
+    key.cullerSetVersion = culler.getDrawSetVersion();
+    // Culled draws are indirect, so the count only matters without culling
+    key.instanceCount = culledThisFrame ? ~0u : instanceBuffer.getCount();
+    key.sphereLod = sphereLod;
+    key.culled = culledThisFrame;
+    key.impostors = impostorDistance > 0.0f;
+    key.procedural = proceduralSphere;
+    if (!(key == sceneKey)) {
+        sceneKey = key;
+        sceneVersion++;
+    }
+}
+
+void GraphicsModule::createCameraBuffers() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &cameraSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create camera descriptor set layout");
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxFramesInFlight };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    poolInfo.maxSets = maxFramesInFlight;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &cameraDescriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create camera descriptor pool");
+
+    for (auto& frame : frames) {
+        createBuffer(device, allocator, sizeof(CameraUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     frame.cameraBuffer, frame.cameraAllocation);
+        frame.cameraVersion = 0;
+
+        VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        allocInfo.descriptorPool = cameraDescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &cameraSetLayout;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.cameraSet) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate camera descriptor set");
+
+        VkDescriptorBufferInfo bufferInfo{ frame.cameraBuffer, 0, sizeof(CameraUniforms) };
+        VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        write.dstSet = frame.cameraSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+}
+
+void GraphicsModule::destroyCameraBuffers() {
+    for (auto& frame : frames)
+        destroyBuffer(device, allocator, frame.cameraBuffer, frame.cameraAllocation);
+    if (cameraDescriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, cameraDescriptorPool, nullptr);
+        cameraDescriptorPool = VK_NULL_HANDLE;
+    }
+    if (cameraSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, cameraSetLayout, nullptr);
+        cameraSetLayout = VK_NULL_HANDLE;
     }
 }
+
+void GraphicsModule::bindCamera(VkCommandBuffer cmd, VkPipelineLayout layout) {
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &frames[currentFrame].cameraSet,
+                            0, nullptr);
+}
+
+void GraphicsModule::setSphereMesh(const GpuMesh& mesh, bool owned) {
+    if (sphereMesh.valid() && sphereMeshOwned)
+        retireMesh(sphereMesh);
+    sphereMesh = mesh;
+    sphereMeshOwned = owned;
+    sphereLod = NoLod;
+    meshGeneration++;
+}
+
+void GraphicsModule::retireMesh(const GpuMesh& mesh) {
+    GpuMesh retired = mesh;
+    deferDestroy([this, retired]() mutable {
+        GeomCreate::destroyMesh(device, allocator, retired);
+    });
+}
+
+void GraphicsModule::deferDestroy(std::function<void()> destroy) {
+    deferredDestroys.push_back({ submittedFrames, std::move(destroy) });
+}
+
+void GraphicsModule::runDeferredDestroys(bool all) {
+    // After waiting on the current slot's fence, frame (submittedFrames - maxFramesInFlight)
+    // and everything submitted before it on the graphics queue has completed. An entry
+    // retired before frame R was recorded is safe once frame R is done (R also waited on
+    // any upload of the retired buffers).
+    while (!deferredDestroys.empty() &&
+           (all || deferredDestroys.front().frame + maxFramesInFlight <= submittedFrames)) {
+        deferredDestroys.front().destroy();
+        deferredDestroys.pop_front();
+    }
+}
+
+void GraphicsModule::destroySphereBuffers() {
+    // Only called at shutdown, after the device has been idled
+    if (sphereMeshOwned)
+        GeomCreate::destroyMesh(device, allocator, sphereMesh);
+    sphereMesh = GpuMesh{};
+}
@@ -6,16 +6,40 @@
 #include <stdexcept>
 #include <string>
 #include <functional>
+#include <deque>
+#include <chrono>
 #include <HelpStructures.h>
 #include "ArcBallCamera.h"
+#include "GpuAllocator.h"
+#include "UploadManager.h"
+#include "Mesh.h"
+#include "InstanceBuffer.h"
+#include "FrustumCuller.h"
+#include "PipelineCache.h"
+#include "Profiler.h"
+#include "ParallelRecorder.h"
 #include <glm/glm.hpp>
 
 
 class GraphicsModule {
 public:
+    // Render into offscreen images instead of a window: no SDL, no surface, no present.
+    // Must be called before init().
+    void setHeadless(uint32_t width, uint32_t height);
+    bool isHeadless() const { return headless; }
+
     void init();
     void cleanup();
-    void pollEvents(); // Already exists
+    // Handles pending window events. Returns true if user input or a window event arrived
+    // (SDL user events, used as wake-ups, do not count).
+    bool pollEvents();
+    // Blocks until an event is pending, for at most `timeoutMs` (negative: no limit, 0: no
+    // wait). The event is left for pollEvents.
+    void waitEvents(int32_t timeoutMs);
+    // Frame pacing; call after waitEvents and right before pollEvents, so the input a frame
+    // is drawn with is sampled as late as possible. Sleeps for the frame rate limit and,
+    // with low latency on, waits for the previous frame to be presented.
+    void waitForFrame();
     bool shouldClose() const; // Already exists
 
     // Getters for ImGuiModule
@@ -25,34 +49,124 @@ public:
     VkDevice getDevice() const { return device; }
     VkQueue getGraphicsQueue() const { return graphicsQueue; }
     uint32_t getGraphicsQueueFamilyIndex() const { return graphicsQueueFamilyIndex; }
-    VkRenderPass getRenderPass() const { return renderPass; }
+    UploadManager& getUploader() { return uploader; }
+    GpuAllocator& getAllocator() { return allocator; }
+    // Attachment formats of the main pass (dynamic rendering), for pipelines drawn into it
+    VkFormat getColorFormat() const { return swapchainImageFormat; }
+    VkFormat getDepthFormat() const { return depthFormat; }
     const std::vector<VkImageView>& getSwapchainImageViews() const { return swapchainImageViews; }
     VkCommandBuffer getCommandBuffer(uint32_t index) const {
-        if (index >= commandBuffers.size()) {
+        if (index >= frames.size()) {
             throw std::out_of_range("Command buffer index out of range.");
         }
-        return commandBuffers[index];
+        return frames[index].commandBuffer;
     }
 
+    // Number of frames the CPU may record ahead of the GPU. Must be set before init().
+    void setMaxFramesInFlight(uint32_t count) { maxFramesInFlight = count > 0 ? count : 1; }
+    uint32_t getMaxFramesInFlight() const { return maxFramesInFlight; }
+    const FrameStats& getFrameStats() const { return frameStats; }
+    const StartupStats& getStartupStats() const { return startupStats; }
+    Profiler& getProfiler() { return profiler; }
+
+    // File the pipeline cache is loaded from in init() and saved to in cleanup().
+    // Must be set before init(); an empty path disables persistence.
+    void setPipelineCachePath(const std::string& path) { pipelineCachePath = path; }
+    VkPipelineCache getPipelineCache() const { return pipelineCache.get(); }
+
+    // === Presentation ===
+    // Present mode to ask for. An unsupported mode falls back to its nearest sibling
+    // (MAILBOX and IMMEDIATE to each other), then to FIFO, which is always there. A change
+    // recreates the swapchain in the next handleResizeIfNeeded().
+    void setPresentMode(VkPresentModeKHR mode);
+    VkPresentModeKHR getRequestedPresentMode() const { return requestedPresentMode; }
+    // Mode of the current swapchain
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+    bool isPresentModeSupported(VkPresentModeKHR mode) const;
+    // Swapchain images to ask for, clamped to the surface limits; 0 takes the surface
+    // minimum plus one. MAILBOX needs three to run ahead of the display.
+    void setSwapchainImageCount(uint32_t count);
+    uint32_t getSwapchainImageCount() const { return static_cast<uint32_t>(swapchainImages.size()); }
+    // Frames per second waitForFrame() holds the loop to; 0 for no limit
+    void setFrameRateLimit(float fps) { frameRateLimit = fps > 0.0f ? fps : 0.0f; }
+    float getFrameRateLimit() const { return frameRateLimit; }
+    // Let waitForFrame() block until the previous frame is on screen (VK_KHR_present_wait),
+    // or has finished on the GPU without it. Lowest input lag, but the CPU no longer
+    // records ahead of the GPU, so a frame that misses a vblank costs a whole interval.
+    void setLowLatency(bool enabled) { lowLatency = enabled; }
+    bool isLowLatency() const { return lowLatency; }
+    // Whether input latency is measured to the image reaching the display rather than to
+    // vkQueuePresentKHR
+    bool hasPresentWait() const { return presentWaitSupported; }
+
 
     // Frame handling
     void beginFrame();
     void draw(std::function<void(VkCommandBuffer)> renderCallback);
+    // Like draw(), but each task records into its own secondary command buffer, on the
+    // recording workers unless it asks for the main thread. Tasks run concurrently, so a
+    // task must not write state another task reads; drawSphere and drawSphereInstances only
+    // read.
+    void drawTasks(const std::vector<RenderTask>& tasks);
+    // Worker threads recording drawTasks() tasks next to the calling thread; 0 records on
+    // the calling thread only. Call between frames.
+    void setRecordThreads(uint32_t workers);
+    uint32_t getRecordThreads() const { return recordWorkers; }
     void handleResizeIfNeeded();
 
     void createGraphicsPipeline();
     void drawSphere(VkCommandBuffer cmd);
+    // Draws drones [firstInstance, firstInstance + count) with the finest mesh level, ignoring
+    // culling; lets a large fleet be split into batches that record in parallel
+    void drawSphereInstances(VkCommandBuffer cmd, uint32_t firstInstance, uint32_t count);
+    // Changes whenever drawSphere would record different commands. The camera is not part
+    // of it: the matrices are read from a per-frame buffer. A RenderTask drawing the sphere
+    // returns this as its cacheVersion, so an unchanged scene is not re-recorded.
+    uint64_t getSceneVersion() const { return sceneVersion; }
+
+    // === Sphere geometry ===
+    // Swaps in a new mesh at a frame boundary. An owned mesh is retired when replaced and
+    // destroyed at cleanup; a borrowed one (e.g. owned by GeometryCache) is left alone.
+    void setSphereMesh(const GpuMesh& mesh, bool owned = true);
+    const GpuMesh& getSphereMesh() const { return sphereMesh; }
+    uint32_t getIndexCount() const { return sphereMesh.indexCount; }
 
-    // === Public accessors for sphere geometry ===
-    VkBuffer& getVertexBuffer() { return vertexBuffer; }
-    VkDeviceMemory& getVertexMemory() { return vertexMemory; }
-    VkBuffer& getIndexBuffer() { return indexBuffer; }
-    VkDeviceMemory& getIndexMemory() { return indexMemory; }
-    void setIndexCount(uint32_t count) { indexCount = count; }
-    uint32_t getIndexCount() const { return indexCount; }
+    // Destroys the mesh once every frame submitted so far has finished on the GPU
+    void retireMesh(const GpuMesh& mesh);
+    // Runs `destroy` once every frame submitted so far has finished on the GPU
+    void deferDestroy(std::function<void()> destroy);
 
     void destroySphereBuffers();
 
+    // === Instanced drones ===
+    // Bulk per-frame update; call between frames. While the count is non-zero, drawSphere
+    // draws the sphere mesh once per instance with sphere_instanced.vert.
+    InstanceData* writeInstances(uint32_t count) { return instanceBuffer.write(count); }
+    void updateInstances(const InstanceData* data, uint32_t count) { instanceBuffer.update(data, count); }
+    uint32_t getInstanceCount() const { return instanceBuffer.getCount(); }
+    // Cull instances against the camera frustum in a compute pre-pass and draw the
+    // survivors indirectly
+    void setGpuCulling(bool enabled) { gpuCulling = enabled; }
+    bool isGpuCulling() const { return gpuCulling; }
+    // Screen-space error budget for picking a level of a LOD chain mesh. Per drone it is
+    // applied in the culling pass; without GPU culling drones draw the finest level.
+    void setLodPixelError(float pixels) { lodPixelError = pixels > 0.0f ? pixels : 1.0f; }
+    float getLodPixelError() const { return lodPixelError; }
+    // Level the single sphere was last drawn with (NoLod before the first draw)
+    uint32_t getSphereLod() const { return sphereLod; }
+
+    // Drones further than `distance` (world units) from the camera are drawn as ray-cast
+    // sphere impostors instead of meshes; 0 disables. Chosen in the culling pass, so it
+    // only applies with GPU culling on.
+    void setImpostorDistance(float distance) { impostorDistance = distance > 0.0f ? distance : 0.0f; }
+    float getImpostorDistance() const { return impostorDistance; }
+
+    // === Procedural sphere ===
+    // While enabled, drawSphere ignores the sphere mesh and generates the sphere in the
+    // vertex shader with no vertex or index buffer bound
+    void setProceduralSphere(const ProceduralSphere& sphere) { proceduralSphere = sphere; }
+    const ProceduralSphere& getProceduralSphere() const { return proceduralSphere; }
+
     ArcBallCamera camera;
 
 private:
@@ -60,6 +174,10 @@ private:
     SDL_Window* window = nullptr;
     bool m_windowShouldClose = false;
     bool m_framebufferResized = false;
+    bool headless = false;
+    VkExtent2D headlessExtent{ 1280, 720 };
+    // SDL timestamp (ns) of the oldest input not yet drawn; 0 when there is none
+    uint64_t pendingInputNs = 0;
 
     // Vulkan objects
     VkInstance instance = VK_NULL_HANDLE;
@@ -68,15 +186,103 @@ private:
     VkDevice device = VK_NULL_HANDLE;
     VkQueue graphicsQueue = VK_NULL_HANDLE;
     uint32_t graphicsQueueFamilyIndex = 0;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    uint32_t transferQueueFamilyIndex = 0;
+    GpuAllocator allocator;
+    UploadManager uploader;
     VkSwapchainKHR swapchain = VK_NULL_HANDLE;
     VkFormat swapchainImageFormat;
     VkExtent2D swapchainExtent;
     std::vector<VkImage> swapchainImages;
     std::vector<VkImageView> swapchainImageViews;
-    VkRenderPass renderPass = VK_NULL_HANDLE;
     VkCommandPool commandPool = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> commandBuffers;
-    std::vector<VkFramebuffer> swapchainFramebuffers;
+    std::vector<GpuAllocation> offscreenAllocations; // headless stand-ins for swapchain images
+
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkImage depthImage = VK_NULL_HANDLE;
+    GpuAllocation depthAllocation;
+    VkImageView depthImageView = VK_NULL_HANDLE;
+
+    // Frames in flight
+    struct FrameData {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence inFlightFence = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        bool timestampsPending = false;  // GPU frame timestamps written, not yet read back
+        // CameraUniforms for this slot, persistently mapped; rewritten when the camera changed
+        VkBuffer cameraBuffer = VK_NULL_HANDLE;
+        GpuAllocation cameraAllocation;
+        VkDescriptorSet cameraSet = VK_NULL_HANDLE;
+        uint64_t cameraVersion = 0;
+    };
+    static constexpr uint32_t DefaultFramesInFlight = 2;
+    uint32_t maxFramesInFlight = DefaultFramesInFlight;
+    uint32_t currentFrame = 0;
+    std::vector<FrameData> frames;
+    // Indexed by swapchain image: a present may still be reading the semaphore
+    // when the frame slot that signalled it comes around again.
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+    std::vector<VkFence> imagesInFlight;
+
+    // Presentation settings and pacing
+    VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    std::vector<VkPresentModeKHR> supportedPresentModes;
+    uint32_t requestedImageCount = 0;
+    float frameRateLimit = 0.0f;
+    bool lowLatency = false;
+    std::chrono::steady_clock::time_point nextFrameDue{};
+    // Present ids count the presents to the current swapchain, starting at 1
+    bool presentWaitSupported = false;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+    uint64_t lastPresentId = 0;
+    // Frames drawn with pending input, waiting for their present to complete
+    struct LatencyProbe {
+        uint64_t presentId;
+        uint64_t inputNs;
+    };
+    std::deque<LatencyProbe> latencyProbes;
+    void recordInputLatency(uint64_t inputNs);
+    // Resolves the probes whose present has completed, without blocking. Polled once or
+    // twice a frame, so the latency may read up to a frame long unless low latency
+    // pacing waits on the present itself.
+    void collectPresents();
+    FrameStats frameStats;
+    StartupStats startupStats;
+    Profiler profiler;
+    // Two timestamps per frame slot bracketing the whole command buffer. Kept apart from the
+    // profiler's pool so frameStats.gpuFrameMs (and the headless report) does not depend on
+    // the profiler being compiled in or on which passes it scoped.
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    TimestampProperties frameTimestamps;
+    void createTimestampQueries();
+    void readFrameTimestamps(FrameData& frame, uint32_t slot);
+    uint64_t submittedFrames = 0;
+
+    VkDescriptorSetLayout cameraSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool cameraDescriptorPool = VK_NULL_HANDLE;
+    void createCameraBuffers();
+    void destroyCameraBuffers();
+    // Set 1 of every sphere pipeline layout; bound per layout, as their push constant
+    // ranges differ
+    void bindCamera(VkCommandBuffer cmd, VkPipelineLayout layout);
+
+    // Exactly one of the two is non-null
+    void drawFrame(const std::function<void(VkCommandBuffer)>* renderCallback,
+                   const std::vector<RenderTask>* tasks);
+    ParallelRecorder recorder;
+    static constexpr uint32_t DefaultRecordWorkers = 2;
+    uint32_t recordWorkers = DefaultRecordWorkers;
+    std::vector<VkCommandBuffer> secondaryBuffers;
+
+    // Resources the GPU may still reference, destroyed once the frame they were retired in
+    // has completed
+    struct DeferredDestroy {
+        uint64_t frame;
+        std::function<void()> destroy;
+    };
+    std::deque<DeferredDestroy> deferredDestroys;
+    void runDeferredDestroys(bool all);
 
     // Private initialization steps
     void initSDL();
@@ -85,25 +291,87 @@ private:
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createSwapchain();
+    void createOffscreenImages();
+    void destroySwapchainImages();
     void createImageViews();
-    void createRenderPass();
+    void createDepthResources();
+    void destroyDepthResources();
     void createCommandPoolAndBuffers();
-    void createFramebuffers();
+    // Synchronization2 layout transitions around the main pass: into attachment layouts
+    // before it, the color image on to present (or transfer source headless) after it
+    void transitionAttachments(VkCommandBuffer cmd, VkImage colorImage, bool toAttachment);
+    void createSyncObjects();
+    void createRenderFinishedSemaphores();
+    void destroyRenderFinishedSemaphores();
 
     bool wasFramebufferResized() const;
     void acknowledgeResize();
     void recreateSwapchain();
 
     // Shader pipeline members
+    PipelineCache pipelineCache;
+    std::string pipelineCachePath = "pipeline_cache.bin";
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
-
-    // Sphere geometry buffers
-    VkBuffer vertexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
-    VkBuffer indexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory indexMemory = VK_NULL_HANDLE;
-    uint32_t indexCount = 0;
+    VkPipelineLayout instancedPipelineLayout = VK_NULL_HANDLE;
+    // One variant per VertexFormat: vertex input state and normal decoding differ
+    VkPipeline graphicsPipelines[VertexFormatCount] = {};
+    VkPipeline instancedPipelines[VertexFormatCount] = {};
+    VkPipeline proceduralPipeline = VK_NULL_HANDLE;
+    VkPipeline proceduralInstancedPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout impostorPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline impostorPipeline = VK_NULL_HANDLE;
+    // Without vertex input when `procedural`; `format` is ignored then
+    VkPipeline createSpherePipeline(const std::string& vertShader, VkPipelineLayout layout, VertexFormat format,
+                                    bool procedural = false, const std::string& fragShader = "sphere.frag.spv",
+                                    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT);
+
+    InstanceBuffer instanceBuffer;
+    FrustumCuller culler;
+    bool drawIndirectCountSupported = false;
+    bool gpuCulling = true;
+    bool culledThisFrame = false;
+    void recordCulling(VkCommandBuffer cmd);
+    // Per frame: camera buffer, single-sphere LOD, scene version. Runs after the culling
+    // dispatch is recorded and before the sphere pass, because the scene key includes
+    // whether this frame culled (culledThisFrame) and the culler's draw set version, both
+    // settled by recordCulling; earlier it would compare stale state and reuse commands
+    // recorded for the other draw path.
+    void prepareScene();
+    float lodPixelError = 1.0f;
+    float impostorDistance = 0.0f;
+    void drawImpostors(VkCommandBuffer cmd);
+    uint32_t sphereLod = NoLod;
+    float pixelsPerUnit() const;
+
+    // Everything drawSphere's commands depend on besides the camera
+    struct SceneKey {
+        uint64_t meshGeneration = 0;
+        uint64_t swapchainGeneration = 0;
+        uint64_t instanceSetVersion = 0;
+        uint64_t cullerSetVersion = 0;
+        uint32_t instanceCount = 0;
+        uint32_t sphereLod = NoLod;
+        bool culled = false;
+        bool impostors = false;
+        ProceduralSphere procedural;
+
+        bool operator==(const SceneKey& other) const {
+            return meshGeneration == other.meshGeneration && swapchainGeneration == other.swapchainGeneration &&
+                   instanceSetVersion == other.instanceSetVersion && cullerSetVersion == other.cullerSetVersion &&
+                   instanceCount == other.instanceCount && sphereLod == other.sphereLod &&
+                   culled == other.culled && impostors == other.impostors && procedural == other.procedural;
+        }
+    };
+    SceneKey sceneKey;
+    uint64_t sceneVersion = 1;
+    uint64_t meshGeneration = 0;
+    uint64_t swapchainGeneration = 0;
+
+    // Sphere geometry
+    GpuMesh sphereMesh;
+    bool sphereMeshOwned = true;
+    ProceduralSphere proceduralSphere;
+    void drawProceduralSphere(VkCommandBuffer cmd);
 
     bool mousePressed = false;
     int lastMouseX = 0;
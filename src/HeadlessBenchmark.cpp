@@ -0,0 +1,335 @@
+// HeadlessBenchmark.cpp
+#include "HeadlessBenchmark.h"
+#include "GraphicsModule.h"
+#include "DroneFleet.h"
+#include "GeomCreate.h"
+#include "Tracer.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+const char* sphereTypeName(SphereType type) {
+    switch (type) {
+    case SphereType::LowPoly: return "lowpoly";
+    case SphereType::UVSphere: return "uv";
+    case SphereType::Icosphere: return "icosphere";
+    case SphereType::IcosphereLod: return "icosphere-lod";
+    }
+    return "unknown";
+}
+
+const char* vertexFormatName(VertexFormat format) {
+    return format == VertexFormat::Packed ? "packed" : "float";
+}
+
+// Upper bounds for the count options, as in the benches
+constexpr uint32_t MaxFrames = 1000000;
+constexpr uint32_t MaxDrones = 10000000;
+// Upper bound for each --size dimension. Options are parsed before a device exists, so this
+// is the maxImageDimension2D of current desktop GPUs rather than the device's own limit.
+constexpr uint32_t MaxImageSize = 16384;
+
+// `text` as an integer in [minValue, maxValue]
+bool parseUint(const char* text, uint32_t minValue, uint32_t maxValue, uint32_t& value) {
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > maxValue)
+        return false;
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+// {"mean":..,"min":..,"p50":..,...} over `samples`, or null when there are none
+std::string percentiles(std::vector<double> samples) {
+    if (samples.empty())
+        return "null";
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t index = static_cast<size_t>(q * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    double sum = 0.0;
+    for (double ms : samples) sum += ms;
+
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{ \"samples\": %zu, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, "
+                  "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+                  samples.size(), sum / samples.size(), samples.front(), at(0.50), at(0.90),
+                  at(0.95), at(0.99), samples.back());
+    return buffer;
+}
+}
+
+const char* HeadlessBenchmark::usage() {
+    return "Usage: DroneVisualizer --headless [options]\n"
+           "  --frames N           measured frames, 1..1000000 (default 600)\n"
+           "  --warmup N           unmeasured frames before measuring (default 60)\n"
+           "  --size WxH           render target size, each side 1..16384 (default 1280x720)\n"
+           "  --sphere TYPE        lowpoly | uv | icosphere | icosphere-lod (default icosphere)\n"
+           "  --lat N --lon N      UV/low-poly divisions, 3..256 (default 16)\n"
+           "  --subdiv N           icosphere subdivisions 0..8, finest level 0..7 for icosphere-lod (default 3)\n"
+           "  --vertex-format F    float | packed (default float)\n"
+           "  --no-optimize        skip the vertex cache / vertex fetch reordering\n"
+           "  --procedural         generate the sphere in the vertex shader, no vertex/index buffers\n"
+           "  --drones N           instance count up to 10000000, 0 for a single sphere (default 10000)\n"
+           "  --no-culling         disable GPU frustum culling\n"
+           "  --impostor-distance D  drones beyond D world units become impostors (needs culling)\n"
+           "  --output FILE        write the JSON report to FILE instead of stdout\n"
+           "  --trace FILE         capture a Chrome trace of the measured frames\n";
+}
+
+bool HeadlessBenchmark::parseArguments(int argc, char* argv[], BenchmarkConfig& config, std::string& error) {
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto needValue = [&]() {
+            if (!value) error = "missing value for " + arg;
+            return value != nullptr;
+        };
+        auto uintOption = [&](uint32_t& out, uint32_t minValue, uint32_t maxValue) {
+            if (!needValue()) return false;
+            ++i;
+            if (!parseUint(value, minValue, maxValue, out)) {
+                error = "invalid value for " + arg + ": " + value + " (expected " + std::to_string(minValue) +
+                        ".." + std::to_string(maxValue) + ")";
+                return false;
+            }
+            return true;
+        };
+
+        if (arg == "--frames") {
+            if (!uintOption(config.frames, 1, MaxFrames)) return false;
+        } else if (arg == "--warmup") {
+            if (!uintOption(config.warmupFrames, 0, MaxFrames)) return false;
+        } else if (arg == "--lat") {
+            if (!uintOption(config.geometry.latDiv, GeomCreate::MinSphereDivisions, GeomCreate::MaxSphereDivisions))
+                return false;
+        } else if (arg == "--lon") {
+            if (!uintOption(config.geometry.lonDiv, GeomCreate::MinSphereDivisions, GeomCreate::MaxSphereDivisions))
+                return false;
+        } else if (arg == "--subdiv") {
+            if (!uintOption(config.geometry.subdivisions, 0, GeomCreate::MaxIcosphereSubdivisions)) return false;
+        } else if (arg == "--drones") {
+            if (!uintOption(config.droneCount, 0, MaxDrones)) return false;
+        } else if (arg == "--size") {
+            if (!needValue()) return false;
+            ++i;
+            std::string size = value;
+            size_t x = size.find('x');
+            uint32_t width = 0, height = 0;
+            if (x == std::string::npos || !parseUint(size.substr(0, x).c_str(), 1, MaxImageSize, width) ||
+                !parseUint(size.substr(x + 1).c_str(), 1, MaxImageSize, height)) {
+                error = std::string("invalid size: ") + value + " (expected WxH, each 1.." +
+                        std::to_string(MaxImageSize) + ")";
+                return false;
+            }
+            config.width = width;
+            config.height = height;
+        } else if (arg == "--sphere") {
+            if (!needValue()) return false;
+            ++i;
+            if (std::strcmp(value, "lowpoly") == 0) config.geometry.type = SphereType::LowPoly;
+            else if (std::strcmp(value, "uv") == 0) config.geometry.type = SphereType::UVSphere;
+            else if (std::strcmp(value, "icosphere") == 0) config.geometry.type = SphereType::Icosphere;
+            else if (std::strcmp(value, "icosphere-lod") == 0) config.geometry.type = SphereType::IcosphereLod;
+            else {
+                error = std::string("unknown sphere type: ") + value;
+                return false;
+            }
+        } else if (arg == "--vertex-format") {
+            if (!needValue()) return false;
+            ++i;
+            if (std::strcmp(value, "float") == 0) config.geometry.vertexFormat = VertexFormat::Float32;
+            else if (std::strcmp(value, "packed") == 0) config.geometry.vertexFormat = VertexFormat::Packed;
+            else {
+                error = std::string("unknown vertex format: ") + value;
+                return false;
+            }
+        } else if (arg == "--no-optimize") {
+            config.geometry.optimize = false;
+        } else if (arg == "--procedural") {
+            config.procedural = true;
+        } else if (arg == "--no-culling") {
+            config.gpuCulling = false;
+        } else if (arg == "--impostor-distance") {
+            if (!needValue()) return false;
+            ++i;
+            char* end = nullptr;
+            config.impostorDistance = std::strtof(value, &end);
+            if (end == value || *end != '\0' || !std::isfinite(config.impostorDistance) ||
+                config.impostorDistance < 0.0f) {
+                error = std::string("invalid distance: ") + value;
+                return false;
+            }
+        } else if (arg == "--output") {
+            if (!needValue()) return false;
+            config.outputPath = argv[++i];
+        } else if (arg == "--trace") {
+            if (!needValue()) return false;
+            config.tracePath = argv[++i];
+        } else {
+            error = "unknown option: " + arg;
+            return false;
+        }
+    }
+    if (config.geometry.type == SphereType::IcosphereLod &&
+        config.geometry.subdivisions > GeomCreate::MaxIcosphereLodSubdivisions) {
+        error = "--subdiv for icosphere-lod must be at most " + std::to_string(GeomCreate::MaxIcosphereLodSubdivisions);
+        return false;
+    }
+    return true;
+}
+
+int HeadlessBenchmark::run(const BenchmarkConfig& config) {
+    using Clock = std::chrono::steady_clock;
+
+    GraphicsModule graphics;
+    graphics.setHeadless(config.width, config.height);
+    graphics.init();
+    graphics.setGpuCulling(config.gpuCulling);
+    graphics.setImpostorDistance(config.impostorDistance);
+    if (config.droneCount > 0)
+        graphics.camera.zoom(DroneFleet::ViewZoom);
+
+    VkPhysicalDeviceProperties deviceProps;
+    vkGetPhysicalDeviceProperties(graphics.getPhysicalDevice(), &deviceProps);
+
+    // Same path as the interactive app: build on the worker, keep rendering until resident
+    GeometryWorker geometryWorker;
+    geometryWorker.start(graphics.getDevice(), graphics.getAllocator(), graphics.getUploader());
+
+    std::vector<GpuMesh> retiredMeshes;
+    double geometryMs = 0.0;
+    MeshOptimizerStats optimizerStats;
+    uint64_t vertexBufferBytes = 0;
+    uint64_t indexBufferBytes = 0;
+    if (config.procedural) {
+        ProceduralSphere sphere;
+        sphere.enabled = true;
+        sphere.type = config.geometry.type;
+        sphere.latDiv = config.geometry.latDiv;
+        sphere.lonDiv = config.geometry.lonDiv;
+        sphere.subdivisions = config.geometry.subdivisions;
+        graphics.setProceduralSphere(sphere);
+    } else {
+        geometryWorker.request(config.geometry);
+        auto buildStart = Clock::now();
+        GeometryResult built;
+        while (!geometryWorker.takeCompleted(built, retiredMeshes))
+            graphics.draw(nullptr);
+        if (!built.error.empty()) {
+            std::fprintf(stderr, "Geometry build failed: %s\n", built.error.c_str());
+            geometryWorker.stop(retiredMeshes);
+            for (const auto& retired : retiredMeshes)
+                graphics.retireMesh(retired);
+            graphics.cleanup();
+            return 1;
+        }
+        geometryMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+        graphics.setSphereMesh(built.mesh);
+        optimizerStats = built.optimizerStats;
+        vertexBufferBytes = static_cast<uint64_t>(built.mesh.vertexCount) *
+                            GeomCreate::vertexStride(built.mesh.vertexFormat);
+        indexBufferBytes = static_cast<uint64_t>(built.mesh.indexCount) *
+                           (built.mesh.indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4);
+    }
+
+    std::vector<double> frameMs, cpuMs, gpuMs;
+    frameMs.reserve(config.frames);
+    cpuMs.reserve(config.frames);
+    gpuMs.reserve(config.frames);
+
+    const uint32_t totalFrames = config.warmupFrames + config.frames;
+    const float orbitFrames = 360.0f;
+    Tracer& tracer = Tracer::get();
+    tracer.setThreadName("Render thread");
+    if (!config.tracePath.empty())
+        tracer.setOutputPath(config.tracePath);
+
+    for (uint32_t f = 0; f < totalFrames; ++f) {
+        if (f == config.warmupFrames && !config.tracePath.empty())
+            tracer.start();
+        TraceScope frameScope("Frame", "frame");
+        auto start = Clock::now();
+
+        // Scripted camera: one full orbit every 360 frames with a slow bob in pitch
+        float phase = f * glm::two_pi<float>() / orbitFrames;
+        float prevPhase = (f == 0 ? 0.0f : (f - 1) * glm::two_pi<float>() / orbitFrames);
+        graphics.camera.rotate(glm::two_pi<float>() / orbitFrames,
+                               0.3f * (std::sin(0.5f * phase) - std::sin(0.5f * prevPhase)));
+
+        if (config.droneCount > 0)
+            DroneFleet::layout(graphics.writeInstances(config.droneCount), config.droneCount, f / 60.0f);
+
+        graphics.draw([&](VkCommandBuffer cmd) { graphics.drawSphere(cmd); });
+
+        if (f >= config.warmupFrames) {
+            const FrameStats& stats = graphics.getFrameStats();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            frameMs.push_back(ms);
+            cpuMs.push_back(std::max(0.0, ms - stats.gpuWaitMs)); // frame time minus fence waits
+            if (stats.gpuFrameMs >= 0.0)
+                gpuMs.push_back(stats.gpuFrameMs);
+        }
+    }
+
+    tracer.shutdown();
+    geometryWorker.stop(retiredMeshes);
+    for (const auto& retired : retiredMeshes)
+        graphics.retireMesh(retired);
+    graphics.cleanup();
+
+    // ACMR of each LOD level after optimization, coarsest first
+    std::ostringstream lodAcmr;
+    lodAcmr << "[";
+    for (size_t lod = 0; lod < optimizerStats.lodAfter.size(); ++lod)
+        lodAcmr << (lod ? ", " : "") << optimizerStats.lodAfter[lod].acmr;
+    lodAcmr << "]";
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"device\": \"" << deviceProps.deviceName << "\",\n"
+         << "  \"config\": { \"width\": " << config.width << ", \"height\": " << config.height
+         << ", \"frames\": " << config.frames << ", \"warmupFrames\": " << config.warmupFrames
+         << ", \"sphere\": \"" << sphereTypeName(config.geometry.type) << "\""
+         << ", \"latDiv\": " << config.geometry.latDiv << ", \"lonDiv\": " << config.geometry.lonDiv
+         << ", \"subdivisions\": " << config.geometry.subdivisions
+         << ", \"vertexFormat\": \"" << vertexFormatName(config.geometry.vertexFormat) << "\""
+         << ", \"optimize\": " << (config.geometry.optimize ? "true" : "false")
+         << ", \"procedural\": " << (config.procedural ? "true" : "false")
+         << ", \"drones\": " << config.droneCount
+         << ", \"gpuCulling\": " << (config.gpuCulling ? "true" : "false")
+         << ", \"impostorDistance\": " << config.impostorDistance << " },\n"
+         << "  \"geometryBuildMs\": " << geometryMs << ",\n"
+         << "  \"vertexBufferBytes\": " << vertexBufferBytes << ",\n"
+         << "  \"indexBufferBytes\": " << indexBufferBytes << ",\n"
+         << "  \"acmr\": " << optimizerStats.after.acmr << ", \"atvr\": " << optimizerStats.after.atvr
+         << ", \"lodAcmr\": " << lodAcmr.str() << ",\n"
+         << "  \"frameMs\": " << percentiles(frameMs) << ",\n"
+         << "  \"cpuMs\": " << percentiles(cpuMs) << ",\n"
+         << "  \"gpuMs\": " << percentiles(gpuMs) << "\n"
+         << "}\n";
+
+    if (config.outputPath.empty()) {
+        std::fputs(json.str().c_str(), stdout);
+    } else {
+        std::ofstream file(config.outputPath, std::ios::trunc);
+        file << json.str();
+        if (!file) {
+            std::fprintf(stderr, "Failed to write benchmark report to %s\n", config.outputPath.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+// HeadlessBenchmark.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "GeometryWorker.h"
+
+struct BenchmarkConfig {
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t frames = 600;          // measured frames
+    uint32_t warmupFrames = 60;     // rendered after the mesh is resident, not measured
+    GeometryRequest geometry{ SphereType::Icosphere, 16, 16, 3 };
+    bool procedural = false;        // generate `geometry` in the vertex shader, build no mesh
+    uint32_t droneCount = 10000;    // 0 draws a single sphere
+    bool gpuCulling = true;
+    float impostorDistance = 0.0f;  // drones beyond it are ray-cast impostors; 0 disables
+    std::string outputPath;         // JSON report goes to stdout when empty
+    std::string tracePath;          // Chrome trace of the measured frames when set
+};
+
+// Regression benchmark for GPU-less CI (e.g. lavapipe).
+//
+// Renders a fixed number of frames into offscreen images with no window, surface or
+// present, while the camera follows a scripted orbit that depends only on the frame
+// index. At the end a JSON report with CPU and GPU frame-time percentiles is written.
+class HeadlessBenchmark {
+public:
+    // Parses the options following --headless. Returns false and fills `error` on bad input.
+    static bool parseArguments(int argc, char* argv[], BenchmarkConfig& config, std::string& error);
+    static const char* usage();
+
+    // Returns the process exit code
+    int run(const BenchmarkConfig& config);
+};
@@ -2,6 +2,7 @@
 #define HELPSTRUCTURES_H
 
 
+#include <cstdint>
 #include <glm/glm.hpp>
 
 struct Vertex {
@@ -10,10 +11,101 @@ struct Vertex {
     // glm::vec2 uv;
 };
 
+// Vertex layout of an uploaded mesh
+enum class VertexFormat : uint32_t {
+    Float32,  // Vertex: two vec3, 24 bytes
+    Packed,   // PackedVertex: snorm16 positions and octahedral normals, 12 bytes
+};
+constexpr uint32_t VertexFormatCount = 2;
+
+// Compact vertex: position / GpuMesh::positionScale as snorm16 (w unused, keeps the normal
+// 4-byte aligned) and the unit normal octahedral-encoded into two snorm16
+struct PackedVertex {
+    int16_t position[4];
+    int16_t normal[2];
+};
+
+// Camera matrices in a per-frame-slot uniform buffer (camera.glsl, set 1), so recorded
+// draws do not depend on the camera and cached command buffers survive camera moves
+struct CameraUniforms {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+};
+
 struct PushConstants {
-    glm::mat4 mvp;
     glm::mat4 model;
 };
 
+// Per-drone data read by sphere_instanced.vert (std430, 96 bytes)
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 color;
+    uint32_t state;        // InstanceState bits
+    uint32_t padding[3];
+};
+
+enum InstanceState : uint32_t {
+    InstanceHidden      = 1u << 0,
+    InstanceHighlighted = 1u << 1,
+};
+
+struct InstancedPushConstants {
+    float positionScale;   // GpuMesh::positionScale, 1 for VertexFormat::Float32
+    float padding[3];
+};
+
+// IcosphereLod: every icosphere level up to the subdivision count, selected per object by
+// screen-space error
+enum class SphereType { LowPoly, UVSphere, Icosphere, IcosphereLod };
+
+// Sphere generated in the vertex shader from gl_VertexIndex (procedural_sphere.glsl) with
+// no vertex or index buffer; retessellating only changes push constants
+struct ProceduralSphere {
+    bool enabled = false;
+    SphereType type = SphereType::UVSphere;  // LowPoly draws the bare icosahedron, IcosphereLod its finest level
+    uint32_t latDiv = 16;
+    uint32_t lonDiv = 16;
+    uint32_t subdivisions = 1;
+
+    bool operator==(const ProceduralSphere& other) const {
+        return enabled == other.enabled && type == other.type && latDiv == other.latDiv &&
+               lonDiv == other.lonDiv && subdivisions == other.subdivisions;
+    }
+};
+
+// Push constants of sphere_procedural*.vert; fits both sphere pipeline layouts
+struct ProceduralPushConstants {
+    uint32_t shape;        // 0 UV sphere, 1 icosphere
+    uint32_t latDiv;
+    uint32_t lonDiv;
+    uint32_t subdivisions;
+};
+static_assert(sizeof(ProceduralPushConstants) <= sizeof(InstancedPushConstants),
+              "ProceduralPushConstants must fit the instanced push constant range");
+
+// Per-frame counters reported by GraphicsModule::draw
+struct FrameStats {
+    uint64_t frameIndex = 0;
+    double gpuWaitMs = 0.0;       // CPU time blocked on the frame fence / image fence
+    double avgGpuWaitMs = 0.0;    // exponential moving average of gpuWaitMs
+    double gpuFrameMs = -1.0;     // GPU time of the whole command buffer last completed in this slot; -1 if none was read this frame
+    uint32_t reusedTasks = 0;     // drawTasks() tasks whose cached command buffer was executed without re-recording
+    double paceWaitMs = 0.0;      // time GraphicsModule::waitForFrame blocked (frame limit, low latency)
+    double inputLatencyMs = -1.0; // oldest input event to the present of the first frame drawn after it; -1 if none yet
+    double avgInputLatencyMs = -1.0;
+    bool latencyToDisplay = false; // measured to the present completing (VK_KHR_present_wait), else to vkQueuePresentKHR
+};
+
+// Wall-clock cost of GraphicsModule::init, split so cold and warm pipeline cache runs compare
+struct StartupStats {
+    double deviceMs = 0.0;        // SDL, instance, surface, device, allocators
+    double swapchainMs = 0.0;     // swapchain, depth, sync objects
+    double pipelinesMs = 0.0;     // pipeline cache load plus every pipeline created in init
+    double totalMs = 0.0;
+    bool pipelineCacheWarm = false;
+    size_t pipelineCacheBytes = 0;
+};
+
 
 #endif // HELPSTRUCTURES_H
@@ -7,6 +7,10 @@
 #include "imgui_impl_vulkan.h"
 
 #include "ImGuiModule.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
 #include <stdexcept>
 
 
@@ -16,11 +20,14 @@ void ImGuiModule::init(SDL_Window* window,
                        VkDevice inDevice,
                        VkQueue graphicsQueue,
                        uint32_t queueFamilyIndex,
-                       VkRenderPass renderPass,
-                       uint32_t imageCount)
+                       VkFormat colorFormat,
+                       VkFormat depthFormat,
+                       uint32_t imageCount,
+                       VkPipelineCache pipelineCache)
 {
     device = inDevice;
     physicalDevice = inPhysicalDevice;
+    colorAttachmentFormat = colorFormat;
 
     // 1. Descriptor pool
     VkDescriptorPoolSize poolSizes[] = {
@@ -63,7 +70,12 @@ void ImGuiModule::init(SDL_Window* window,
     initInfo.MinImageCount = imageCount;
     initInfo.ImageCount = imageCount;
     initInfo.QueueFamily = queueFamilyIndex;
-    initInfo.RenderPass = renderPass; // 👈 добавили
+    initInfo.UseDynamicRendering = true;
+    initInfo.PipelineRenderingCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    initInfo.PipelineRenderingCreateInfo.colorAttachmentCount = 1;
+    initInfo.PipelineRenderingCreateInfo.pColorAttachmentFormats = &colorAttachmentFormat;
+    initInfo.PipelineRenderingCreateInfo.depthAttachmentFormat = depthFormat;
+    initInfo.PipelineCache = pipelineCache;
 
     ImGui_ImplVulkan_Init(&initInfo);
 }
@@ -77,7 +89,7 @@ void ImGuiModule::renderMenu(VkCommandBuffer commandBuffer) {
     ImGui::Begin("Drone Menu");
     ImGui::Text("Sphere Options");
 
-    const char* types[] = { "LowPoly", "UV Sphere", "Icosphere" };
+    const char* types[] = { "LowPoly", "UV Sphere", "Icosphere", "Icosphere LOD chain" };
     int typeIndex = static_cast<int>(currentType);
 
     if (ImGui::Combo("Sphere Type", &typeIndex, types, IM_ARRAYSIZE(types))) {
@@ -90,14 +102,185 @@ void ImGuiModule::renderMenu(VkCommandBuffer commandBuffer) {
         if (ImGui::SliderInt("Lon Div", &lonDiv, 3, 64)) geometryChanged = true;
     } else if (currentType == SphereType::Icosphere) {
         if (ImGui::SliderInt("Subdiv", &icoSubdiv, 0, 5)) geometryChanged = true;
+    } else if (currentType == SphereType::IcosphereLod) {
+        if (ImGui::SliderInt("Finest subdiv", &icoSubdiv, 0, 5)) geometryChanged = true;
+        ImGui::SliderFloat("LOD error (px)", &lodPixelError, 0.25f, 8.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        if (droneCount > 0 && !gpuCulling)
+            ImGui::TextDisabled("Per-drone LOD needs GPU culling; drawing the finest level");
     }
+    // Leaving procedural mode needs a mesh for whatever the sliders say now
+    if (ImGui::Checkbox("Procedural (no vertex buffer)", &procedural) && !procedural)
+        geometryChanged = true;
+    if (procedural)
+        ImGui::TextDisabled("Generated from gl_VertexIndex; the options below apply to meshes");
+    const char* vertexFormats[] = { "Float32 (24 B/vertex)", "Packed (12 B/vertex)" };
+    int formatIndex = static_cast<int>(vertexFormat);
+    if (ImGui::Combo("Vertex format", &formatIndex, vertexFormats, IM_ARRAYSIZE(vertexFormats))) {
+        vertexFormat = static_cast<VertexFormat>(formatIndex);
+        geometryChanged = true;
+    }
+    if (ImGui::Checkbox("Optimize vertex order", &optimizeMesh)) geometryChanged = true;
+    if (meshOptimizerStats.optimized)
+        ImGui::Text("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%.1f ms)",
+                    meshOptimizerStats.before.acmr, meshOptimizerStats.after.acmr,
+                    meshOptimizerStats.before.atvr, meshOptimizerStats.after.atvr, meshOptimizerStats.ms);
+    else
+        ImGui::Text("ACMR %.3f, ATVR %.3f (unoptimized)",
+                    meshOptimizerStats.before.acmr, meshOptimizerStats.before.atvr);
+    for (size_t lod = 0; lod < meshOptimizerStats.lodAfter.size(); ++lod)
+        ImGui::Text("  LOD %zu: ACMR %.3f -> %.3f", lod,
+                    meshOptimizerStats.lodBefore[lod].acmr, meshOptimizerStats.lodAfter[lod].acmr);
+    if (geometryBusy)
+        ImGui::TextDisabled("Rebuilding geometry...");
+    if (!geometryError.empty())
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Geometry build failed: %s", geometryError.c_str());
+    ImGui::SliderInt("Geometry cache (MB)", &geometryCacheBudgetMB, 16, 2048, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::Text("Cached meshes: %u, %.1f MB CPU + %.1f MB GPU",
+                geometryCacheStats.entries,
+                geometryCacheStats.cpuBytes / (1024.0 * 1024.0),
+                geometryCacheStats.gpuBytes / (1024.0 * 1024.0));
+    ImGui::Text("Cache hits %llu, misses %llu, evictions %llu",
+                static_cast<unsigned long long>(geometryCacheStats.hits),
+                static_cast<unsigned long long>(geometryCacheStats.misses),
+                static_cast<unsigned long long>(geometryCacheStats.evictions));
+
+    ImGui::SliderInt("Drones", &droneCount, 0, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::Checkbox("GPU frustum culling", &gpuCulling);
+    ImGui::Checkbox("Ray-cast impostors", &impostors);
+    if (impostors) {
+        ImGui::SliderFloat("Impostor distance", &impostorDistance, 1.0f, 100.0f, "%.1f");
+        if (!gpuCulling)
+            ImGui::TextDisabled("Impostors are picked by the culling pass; enable GPU culling");
+    }
+
+    ImGui::Separator();
+    ImGui::Checkbox("Render on demand", &renderOnDemand);
+    if (renderOnDemand)
+        ImGui::SliderFloat("Max idle FPS", &maxIdleFps, 0.0f, 60.0f, "%.0f");
+    ImGui::Separator();
+    const char* presentModes[] = { "FIFO (vsync)", "FIFO relaxed", "Mailbox", "Immediate" };
+    ImGui::Combo("Present mode", &presentModeIndex, presentModes, IM_ARRAYSIZE(presentModes));
+    ImGui::SliderInt("Swapchain images", &swapchainImages, 0, 8, swapchainImages == 0 ? "auto" : "%d");
+    ImGui::SliderFloat("Frame limit", &frameRateLimit, 0.0f, 240.0f, frameRateLimit == 0.0f ? "off" : "%.0f fps");
+    ImGui::Checkbox("Low latency", &lowLatency);
+    const char* activeName = activePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR ? "Immediate"
+                           : activePresentMode == VK_PRESENT_MODE_MAILBOX_KHR ? "Mailbox"
+                           : activePresentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR ? "FIFO relaxed" : "FIFO";
+    ImGui::Text("Presenting: %s, %u images", activeName, activeImageCount);
+    if (frameStats.inputLatencyMs >= 0.0)
+        ImGui::Text("Input latency: %.1f ms (avg %.1f ms) to %s", frameStats.inputLatencyMs,
+                    frameStats.avgInputLatencyMs, frameStats.latencyToDisplay ? "display" : "present call");
+    else
+        ImGui::TextDisabled("Input latency: move the camera to measure");
+    ImGui::Text("Frame pacing wait: %.3f ms", frameStats.paceWaitMs);
+
+    ImGui::Text("Frame %llu", static_cast<unsigned long long>(frameStats.frameIndex));
+    ImGui::Text("CPU wait on GPU: %.3f ms (avg %.3f ms)", frameStats.gpuWaitMs, frameStats.avgGpuWaitMs);
+    ImGui::Text("Cached passes reused: %u", frameStats.reusedTasks);
+    ImGui::Text("Startup: %.1f ms, pipelines %.1f ms (%s pipeline cache)",
+                startupStats.totalMs, startupStats.pipelinesMs,
+                startupStats.pipelineCacheWarm ? "warm" : "cold");
+    if (Tracer::get().isCapturing())
+        ImGui::Text("Capturing trace... (F9 to stop)");
+    else if (Tracer::get().isWriting())
+        ImGui::TextDisabled("Writing trace...");
+    else
+        ImGui::TextDisabled("F9: capture trace");
+
+    ImGui::Separator();
+    ImGui::Text("GPU memory: %.2f / %.2f MB in %u blocks",
+                memoryStats.bytesUsed / (1024.0 * 1024.0),
+                memoryStats.bytesReserved / (1024.0 * 1024.0),
+                memoryStats.blockCount);
+    ImGui::Text("Allocations: %u, fragmentation %.1f%%",
+                memoryStats.allocationCount, memoryStats.fragmentation * 100.0f);
 
     ImGui::End();
 
+    renderProfilerPanel();
+
     ImGui::Render();
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 }
 
+void ImGuiModule::renderProfilerPanel() {
+    if (!Profiler::Enabled || !profiler || profiler->getSampleCount() == 0)
+        return;
+
+    uint32_t count = profiler->getSampleCount();
+    cpuGraph.resize(count);
+    gpuGraph.resize(count);
+
+    struct PhaseStats { float last = -1.0f, sum = 0.0f, max = 0.0f; uint32_t samples = 0; };
+    auto accumulate = [](PhaseStats& stats, float ms) {
+        if (ms < 0.0f) return;  // GPU result not read back yet
+        stats.last = ms;
+        stats.sum += ms;
+        stats.max = std::max(stats.max, ms);
+        stats.samples++;
+    };
+    PhaseStats cpu[CpuPhaseCount], gpu[GpuPhaseCount], cpuTotal, gpuScopes;
+
+    float lastGpuScopes = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        const ProfileSample& sample = profiler->getSample(i);
+        float cpuSum = 0.0f;
+        for (uint32_t p = 0; p < CpuPhaseCount; ++p) {
+            accumulate(cpu[p], sample.cpuMs[p]);
+            cpuSum += sample.cpuMs[p];
+        }
+        accumulate(cpuTotal, cpuSum);
+        cpuGraph[i] = cpuSum;
+
+        for (uint32_t p = 0; p < GpuPhaseCount; ++p)
+            accumulate(gpu[p], sample.gpuMs[p]);
+        // Not a sum of the phases: culling only runs on some frames, and the span also covers
+        // the gaps between them
+        if (sample.gpuScopesMs >= 0.0f) {
+            accumulate(gpuScopes, sample.gpuScopesMs);
+            lastGpuScopes = sample.gpuScopesMs;
+        }
+        gpuGraph[i] = lastGpuScopes;  // frames still in flight repeat the previous value
+    }
+
+    ImGui::Begin("Profiler");
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "CPU %.3f ms", cpuTotal.last);
+    ImGui::PlotLines("##cpu", cpuGraph.data(), static_cast<int>(count), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+    snprintf(overlay, sizeof(overlay), "GPU scopes %.3f ms", gpuScopes.last);
+    ImGui::PlotLines("##gpu", gpuGraph.data(), static_cast<int>(count), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+    if (ImGui::BeginTable("phases", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        auto row = [](const char* name, const PhaseStats& stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.samples ? stats.sum / stats.samples : 0.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.max);
+        };
+        for (uint32_t p = 0; p < CpuPhaseCount; ++p)
+            row(phaseName(static_cast<CpuPhase>(p)), cpu[p]);
+        row("CPU total", cpuTotal);
+        for (uint32_t p = 0; p < GpuPhaseCount; ++p)
+            row(phaseName(static_cast<GpuPhase>(p)), gpu[p]);
+        row("GPU scopes", gpuScopes);
+        ImGui::EndTable();
+    }
+    ImGui::Text("Last geometry rebuild (worker): %.2f ms", lastGeometryBuildMs);
+
+    ImGui::End();
+}
 
 void ImGuiModule::cleanup() {
     ImGui_ImplVulkan_Shutdown();
@@ -298,4 +481,12 @@ void ImGuiModule::uploadFonts(VkCommandBuffer cmd, VkQueue graphicsQueue)
     // NOTE: you can optionally store and destroy `fontImage`, `fontImageView`, `fontSampler` in your cleanup later
 }
 
+bool ImGuiModule::isAnimating() const {
+    return ImGui::IsAnyItemActive() || ImGui::GetIO().WantTextInput;
+}
 
+VkPresentModeKHR ImGuiModule::getPresentMode() const {
+    const VkPresentModeKHR modes[] = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+                                       VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+    return modes[presentModeIndex];
+}
@@ -3,6 +3,12 @@
 #include <iostream>
 #include <vulkan/vulkan.h>
 #include <SDL3/SDL.h>
+#include "HelpStructures.h"
+#include "GpuAllocator.h"
+#include "Profiler.h"
+#include "GeometryCache.h"
+#include <string>
+#include <vector>
 
 static void check_vk_result(VkResult err)
 {
@@ -13,8 +19,6 @@ static void check_vk_result(VkResult err)
         abort();
 }
 
-enum class SphereType { LowPoly, UVSphere, Icosphere };
-
 class ImGuiModule {
 public:
     void init(SDL_Window* window,
@@ -23,8 +27,10 @@ public:
               VkDevice device,
               VkQueue graphicsQueue,
               uint32_t queueFamilyIndex,
-              VkRenderPass renderPass,
-              uint32_t imageCount);
+              VkFormat colorFormat,  // attachments of the dynamic rendering pass ImGui draws in
+              VkFormat depthFormat,
+              uint32_t imageCount,
+              VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 
     void renderMenu(VkCommandBuffer commandBuffer);
     void cleanup();
@@ -40,6 +46,20 @@ public:
 
     int latDiv = 16, lonDiv = 16;
     int icoSubdiv = 1;
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    bool optimizeMesh = true;
+    bool procedural = false;       // generate the sphere in the vertex shader, no mesh
+    float lodPixelError = 1.0f;    // screen-space error budget for LOD selection
+    int droneCount = 0;            // 0 draws a single sphere
+    bool gpuCulling = true;
+    bool impostors = false;        // ray-cast impostors beyond impostorDistance
+    float impostorDistance = 40.0f;
+    bool renderOnDemand = true;    // sleep while nothing changes (RedrawScheduler)
+    float maxIdleFps = 30.0f;
+    int presentModeIndex = 0;      // FIFO, FIFO relaxed, Mailbox, Immediate
+    int swapchainImages = 0;       // 0: surface minimum + 1
+    float frameRateLimit = 0.0f;   // 0: unlimited
+    bool lowLatency = false;
 
     bool geometryChanged = false;  // Set to true if user modifies sphere parameters
 
@@ -49,10 +69,72 @@ public:
     int getLatDiv() const { return latDiv; }
     int getLonDiv() const { return lonDiv; }
     int getSubdiv() const { return icoSubdiv; }
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+    bool getOptimizeMesh() const { return optimizeMesh; }
+    ProceduralSphere getProceduralSphere() const {
+        ProceduralSphere sphere;
+        sphere.enabled = procedural;
+        sphere.type = currentType;
+        sphere.latDiv = static_cast<uint32_t>(latDiv);
+        sphere.lonDiv = static_cast<uint32_t>(lonDiv);
+        sphere.subdivisions = static_cast<uint32_t>(icoSubdiv);
+        return sphere;
+    }
+    float getLodPixelError() const { return lodPixelError; }
+    uint32_t getDroneCount() const { return static_cast<uint32_t>(droneCount); }
+    bool getGpuCulling() const { return gpuCulling; }
+    float getImpostorDistance() const { return impostors ? impostorDistance : 0.0f; }
+    bool getRenderOnDemand() const { return renderOnDemand; }
+    float getMaxIdleFps() const { return maxIdleFps; }
+    VkPresentModeKHR getPresentMode() const;
+    uint32_t getSwapchainImages() const { return static_cast<uint32_t>(swapchainImages); }
+    float getFrameRateLimit() const { return frameRateLimit; }
+    bool getLowLatency() const { return lowLatency; }
+    // A widget is being dragged or edited, or a text cursor blinks: ImGui wants frames
+    // without further input
+    bool isAnimating() const;
     void resetGeometryChanged() { geometryChanged = false; }
+    void setGeometryBusy(bool busy) { geometryBusy = busy; }
+    // Why the last geometry build failed; empty once a build succeeds
+    void setGeometryError(const std::string& error) { geometryError = error; }
+
+    // === Frame statistics ===
+    void setFrameStats(const FrameStats& stats) { frameStats = stats; }
+    void setStartupStats(const StartupStats& stats) { startupStats = stats; }
+    void setMemoryStats(const GpuAllocatorStats& stats) { memoryStats = stats; }
+    void setLastGeometryBuildMs(double ms) { lastGeometryBuildMs = ms; }
+    void setGeometryCacheStats(const GeometryCacheStats& stats) { geometryCacheStats = stats; }
+    void setMeshOptimizerStats(const MeshOptimizerStats& stats) { meshOptimizerStats = stats; }
+    // What the swapchain got, which may differ from what was asked for
+    void setPresentStatus(VkPresentModeKHR mode, uint32_t imageCount) {
+        activePresentMode = mode;
+        activeImageCount = imageCount;
+    }
+    size_t getGeometryCacheBudget() const { return static_cast<size_t>(geometryCacheBudgetMB) * 1024 * 1024; }
+
+    // === Profiler ===
+    // Shown in its own window while set; nothing is drawn when the profiler is compiled out
+    void setProfiler(const Profiler* inProfiler) { profiler = inProfiler; }
 
 private:
     VkDevice device = VK_NULL_HANDLE;
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkFormat colorAttachmentFormat = VK_FORMAT_UNDEFINED;  // referenced by ImGui's pipeline create info
+
+    FrameStats frameStats;
+    StartupStats startupStats;
+    VkPresentModeKHR activePresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    uint32_t activeImageCount = 0;
+    GpuAllocatorStats memoryStats;
+    bool geometryBusy = false;
+    std::string geometryError;
+    double lastGeometryBuildMs = 0.0;
+    GeometryCacheStats geometryCacheStats;
+    MeshOptimizerStats meshOptimizerStats;
+    int geometryCacheBudgetMB = 256;
+
+    const Profiler* profiler = nullptr;
+    std::vector<float> cpuGraph, gpuGraph;
+    void renderProfilerPanel();
 };
@@ -0,0 +1,120 @@
+// InstanceBuffer.cpp
+#include "InstanceBuffer.h"
+#include "VulkanHelperMethods.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+void InstanceBuffer::init(VkDevice inDevice, GpuAllocator& inAllocator, uint32_t frameCount,
+                          uint32_t initialCapacity) {
+    device = inDevice;
+    allocator = &inAllocator;
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create instance descriptor set layout");
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    poolInfo.maxSets = frameCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create instance descriptor pool");
+
+    slots.resize(frameCount);
+    std::vector<VkDescriptorSetLayout> layouts(frameCount, setLayout);
+    std::vector<VkDescriptorSet> sets(frameCount);
+    VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = frameCount;
+    allocInfo.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate instance descriptor sets");
+
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        slots[i].set = sets[i];
+        allocateSlot(slots[i], initialCapacity);
+    }
+}
+
+void InstanceBuffer::cleanup() {
+    for (auto& slot : slots)
+        destroyBuffer(device, *allocator, slot.buffer, slot.allocation);
+    slots.clear();
+
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        descriptorPool = VK_NULL_HANDLE;
+    }
+    if (setLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        setLayout = VK_NULL_HANDLE;
+    }
+}
+
+InstanceData* InstanceBuffer::write(uint32_t count) {
+    instances.resize(count);
+    version++;
+    return instances.data();
+}
+
+void InstanceBuffer::update(const InstanceData* data, uint32_t count) {
+    memcpy(write(count), data, sizeof(InstanceData) * count);
+}
+
+void InstanceBuffer::sync(uint32_t frame) {
+    Slot& slot = slots[frame];
+    if (slot.version == version)
+        return;
+
+    uint32_t count = getCount();
+    if (count > slot.capacity) {
+        // Grow by 1.5x so a fleet growing frame by frame does not reallocate every time
+        destroyBuffer(device, *allocator, slot.buffer, slot.allocation);
+        allocateSlot(slot, std::max(count, slot.capacity + slot.capacity / 2));
+    }
+
+    if (count > 0)
+        memcpy(slot.allocation.mapped, instances.data(), sizeof(InstanceData) * count);
+    slot.version = version;
+}
+
+void InstanceBuffer::allocateSlot(Slot& slot, uint32_t capacity) {
+    VkDeviceSize size = sizeof(InstanceData) * std::max(capacity, 1u);
+
+    // Prefer device-local host-visible memory (resizable BAR / UMA) so the shader reads
+    // from VRAM; fall back to plain host-visible memory
+    const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    try {
+        createBuffer(device, *allocator, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     hostVisible | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.buffer, slot.allocation);
+    } catch (const std::runtime_error&) {
+        if (slot.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, slot.buffer, nullptr);
+            slot.buffer = VK_NULL_HANDLE;
+        }
+        createBuffer(device, *allocator, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     hostVisible, slot.buffer, slot.allocation);
+    }
+    slot.capacity = capacity;
+    slot.version = 0;
+
+    VkDescriptorBufferInfo bufferInfo{ slot.buffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = slot.set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    setVersion++;
+}
@@ -0,0 +1,56 @@
+// InstanceBuffer.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "HelpStructures.h"
+#include "GpuAllocator.h"
+
+// Per-instance storage buffer, one copy per frame in flight.
+//
+// The application edits a CPU-side array through write()/update(); each frame slot keeps
+// the version it last uploaded and sync() copies the array into the slot's persistently
+// mapped buffer only when it is stale. A slot's buffer grows in place, which is safe
+// because sync() is only called after the slot's fence has been waited on.
+class InstanceBuffer {
+public:
+    void init(VkDevice device, GpuAllocator& allocator, uint32_t frameCount,
+              uint32_t initialCapacity = 1024);
+    void cleanup();
+
+    // Bulk updates. write() resizes the array and returns it for the caller to fill.
+    InstanceData* write(uint32_t count);
+    void update(const InstanceData* data, uint32_t count);
+    uint32_t getCount() const { return static_cast<uint32_t>(instances.size()); }
+
+    // Render thread, once per frame after the slot's fence wait
+    void sync(uint32_t frame);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout; }
+    VkDescriptorSet getDescriptorSet(uint32_t frame) const { return slots[frame].set; }
+    VkBuffer getBuffer(uint32_t frame) const { return slots[frame].buffer; }
+    // Bumped whenever a slot's descriptor set is rewritten, which invalidates command
+    // buffers that bound it
+    uint64_t getSetVersion() const { return setVersion; }
+
+private:
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+        uint32_t capacity = 0;
+        uint64_t version = 0;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<Slot> slots;
+
+    std::vector<InstanceData> instances;
+    uint64_t version = 1;
+    uint64_t setVersion = 0;
+
+    void allocateSlot(Slot& slot, uint32_t capacity);
+};
@@ -2,11 +2,23 @@
 #include "GraphicsModule.h"
 #include "ImGuiModule.h"
 #include "GeomCreate.h"
+#include "GeometryWorker.h"
+#include "GeometryCache.h"
+#include "DroneFleet.h"
+#include "Tracer.h"
+#include <chrono>
 
 void MainLoop::run() {
     GraphicsModule graphics;
     ImGuiModule ui;
 
+    Tracer& tracer = Tracer::get();
+    tracer.setThreadName("Render thread");
+    if (!tracePath.empty()) {
+        tracer.setOutputPath(tracePath);
+        tracer.start();
+    }
+
     graphics.init();
 
     ui.init(
@@ -16,63 +28,169 @@ void MainLoop::run() {
         graphics.getDevice(),
         graphics.getGraphicsQueue(),
         graphics.getGraphicsQueueFamilyIndex(),
-        graphics.getRenderPass(),
-        static_cast<uint32_t>(graphics.getSwapchainImageViews().size())
+        graphics.getColorFormat(),
+        graphics.getDepthFormat(),
+        static_cast<uint32_t>(graphics.getSwapchainImageViews().size()),
+        graphics.getPipelineCache()
         );
+    ui.setStartupStats(graphics.getStartupStats());
+    ui.setProfiler(&graphics.getProfiler());
 
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+    // Geometry is built and uploaded off the render thread; the first mesh shows up
+    // a frame or two after start-up
+    GeometryWorker geometryWorker;
+    geometryWorker.start(graphics.getDevice(), graphics.getAllocator(), graphics.getUploader());
+    GeometryRequest wantedGeometry;  // Initial default: low-poly sphere
+    geometryWorker.request(wantedGeometry);
 
-    GeomCreate::createLowPolySphere(vertices, indices);  // Initial default
-    GeomCreate::createVertexBuffer(graphics.getDevice(), graphics.getPhysicalDevice(),
-                                   vertices, graphics.getVertexBuffer(), graphics.getVertexMemory());
-    GeomCreate::createIndexBuffer(graphics.getDevice(), graphics.getPhysicalDevice(),
-                                  indices, graphics.getIndexBuffer(), graphics.getIndexMemory());
-    graphics.setIndexCount(static_cast<uint32_t>(indices.size()));
+    // Every finished build lands here; revisiting a configuration is a pointer swap
+    GeometryCache geometryCache;
+
+    std::vector<GpuMesh> retiredMeshes;
+    auto startTime = std::chrono::steady_clock::now();
 
     //ui.uploadFonts(graphics.getCommandBuffer(0), graphics.getGraphicsQueue());
 
+    using Clock = RedrawScheduler::Clock;
+    uint64_t drawnCameraVersion = 0;
+
     // === Main loop ===
     while (!graphics.shouldClose()) {
-        graphics.pollEvents();
+        // On demand, sleep until input, a redraw request or the next animation frame
+        {
+            TraceScope waitScope("Wait for events", "frame");
+            graphics.waitEvents(redraw.waitTimeoutMs(Clock::now()));
+        }
+        // Frame limit and low-latency waits go before input is read, not after the draw
+        graphics.waitForFrame();
+
+        TraceScope frameScope("Frame", "frame");
+        if (!tracePath.empty() && tracer.isCapturing() &&
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() >= traceSeconds) {
+            tracer.stop();
+            tracePath.clear();
+        }
+
+        Profiler& profiler = graphics.getProfiler();
+        {
+            CpuScope scope(profiler, CpuPhase::PollEvents);
+            if (graphics.pollEvents())
+                redraw.onInput(Clock::now());
+        }
+        graphics.setPresentMode(ui.getPresentMode());
+        graphics.setSwapchainImageCount(ui.getSwapchainImages());
+        graphics.setFrameRateLimit(ui.getFrameRateLimit());
+        graphics.setLowLatency(ui.getLowLatency());
         graphics.handleResizeIfNeeded();
         graphics.beginFrame();
 
-        if (ui.hasGeometryChanged()) {
-            vertices.clear();
-            indices.clear();
-
-            switch (ui.getCurrentType()) {
-            case SphereType::LowPoly:
-                GeomCreate::createLowPolySphere(vertices, indices);
-                break;
-            case SphereType::UVSphere:
-                GeomCreate::createUVSphere(ui.getLatDiv(), ui.getLonDiv(), vertices, indices);
-                break;
-            case SphereType::Icosphere:
-                GeomCreate::createIcosphere(ui.getSubdiv(), vertices, indices);
-                break;
+        CpuScope geometryScope(profiler, CpuPhase::Geometry);
+        // A procedural sphere needs no mesh; slider changes wait until it is switched off
+        ProceduralSphere procedural = ui.getProceduralSphere();
+        graphics.setProceduralSphere(procedural);
+        if (ui.hasGeometryChanged() && !procedural.enabled) {
+            GeometryRequest request;
+            request.type = ui.getCurrentType();
+            request.latDiv = static_cast<uint32_t>(ui.getLatDiv());
+            request.lonDiv = static_cast<uint32_t>(ui.getLonDiv());
+            request.subdivisions = static_cast<uint32_t>(ui.getSubdiv());
+            request.vertexFormat = ui.getVertexFormat();
+            request.optimize = ui.getOptimizeMesh();
+            request = GeometryCache::normalize(request);
+
+            wantedGeometry = request;
+            if (const GeometryResult* cached = geometryCache.find(request)) {
+                geometryWorker.cancel();
+                geometryCache.pin(request);
+                graphics.setSphereMesh(cached->mesh, false);
+                ui.setMeshOptimizerStats(cached->optimizerStats);
+                redraw.markDirty();
+            } else {
+                geometryWorker.request(request);
             }
 
-            graphics.destroySphereBuffers(); // Add this method to destroy old Vulkan buffers if needed
-
-            GeomCreate::createVertexBuffer(graphics.getDevice(), graphics.getPhysicalDevice(),
-                                           vertices, graphics.getVertexBuffer(), graphics.getVertexMemory());
-            GeomCreate::createIndexBuffer(graphics.getDevice(), graphics.getPhysicalDevice(),
-                                          indices, graphics.getIndexBuffer(), graphics.getIndexMemory());
-            graphics.setIndexCount(static_cast<uint32_t>(indices.size()));
-
             ui.resetGeometryChanged();
         }
 
-
-        graphics.draw([&](VkCommandBuffer cmd) {
-            graphics.drawSphere(cmd);      // <== добавь этот вызов перед UI
-            ui.renderMenu(cmd);
+        if (ui.getGeometryCacheBudget() != geometryCache.getBudget())
+            geometryCache.setBudget(ui.getGeometryCacheBudget(), retiredMeshes);
+
+        // Frame boundary: cache a finished build and show it if it is still the one wanted,
+        // retire anything superseded or evicted
+        GeometryResult built;
+        if (geometryWorker.takeCompleted(built, retiredMeshes)) {
+            if (!built.error.empty()) {
+                ui.setGeometryError(built.error);  // the previous mesh stays on screen
+                redraw.markDirty();
+            } else {
+                ui.setGeometryError({});
+                bool wanted = GeometryCache::normalize(built.request) == GeometryCache::normalize(wantedGeometry);
+                if (wanted)
+                    geometryCache.pin(built.request);
+                const GeometryResult* cached = geometryCache.insert(std::move(built), retiredMeshes);
+                if (wanted && cached) {
+                    graphics.setSphereMesh(cached->mesh, false);
+                    ui.setMeshOptimizerStats(cached->optimizerStats);
+                    redraw.markDirty();
+                }
+            }
+        }
+        for (const auto& retired : retiredMeshes)
+            graphics.retireMesh(retired);
+        retiredMeshes.clear();
+        geometryScope.stop();
+
+        // Input reaches the camera in pollEvents, but a resize changes its projection too
+        if (graphics.camera.getVersion() != drawnCameraVersion)
+            redraw.markDirty();
+        uint32_t droneCount = ui.getDroneCount();
+        bool startupTrace = !tracePath.empty() && tracer.isCapturing();
+        // Changes over time with no input: drawn at the idle frame rate. A geometry build
+        // also needs frames, which flush its upload.
+        redraw.setAnimating(droneCount > 0 || graphics.getInstanceCount() > 0 || geometryWorker.isBusy() ||
+                            ui.isAnimating() || startupTrace);
+        redraw.setOnDemand(ui.getRenderOnDemand());
+        redraw.setMaxIdleFps(ui.getMaxIdleFps());
+        if (!redraw.shouldDraw(Clock::now()))
+            continue;
+
+        // Instances are rewritten in bulk every frame while a fleet is shown
+        if (droneCount > 0 || graphics.getInstanceCount() > 0) {
+            float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+            DroneFleet::layout(graphics.writeInstances(droneCount), droneCount, time);
+        }
+        graphics.setGpuCulling(ui.getGpuCulling());
+        graphics.setLodPixelError(ui.getLodPixelError());
+        graphics.setImpostorDistance(ui.getImpostorDistance());
+
+        // The spheres record on a worker while the UI, which ImGui confines to this
+        // thread, records here. The sphere pass is only re-recorded when the scene changes;
+        // camera moves and fleet animation reach the GPU through buffers.
+        graphics.drawTasks({
+            { "Spheres", [&](VkCommandBuffer cmd) { graphics.drawSphere(cmd); }, false,
+              [&] { return graphics.getSceneVersion(); } },
+            { "ImGui", [&](VkCommandBuffer cmd) {
+                  ui.setFrameStats(graphics.getFrameStats());
+                  ui.setPresentStatus(graphics.getPresentMode(), graphics.getSwapchainImageCount());
+                  ui.setMemoryStats(graphics.getAllocator().getStats());
+                  ui.setGeometryBusy(geometryWorker.isBusy());
+                  ui.setLastGeometryBuildMs(geometryWorker.getLastBuildMs());
+                  ui.setGeometryCacheStats(geometryCache.getStats());
+                  GpuScope imguiScope(profiler, cmd, GpuPhase::ImGuiPass);
+                  ui.renderMenu(cmd);
+              }, true },
         });
+        redraw.onFrameDrawn(Clock::now());
+        drawnCameraVersion = graphics.camera.getVersion();
 
     }
 
+    geometryWorker.stop(retiredMeshes);
+    geometryCache.clear(retiredMeshes);
+    for (const auto& retired : retiredMeshes)
+        graphics.retireMesh(retired);
+
+    tracer.shutdown();
     ui.cleanup();
     graphics.cleanup();
 }
@@ -1,7 +1,25 @@
 // MainLoop.h
 #pragma once
 
+#include <string>
+#include "RedrawScheduler.h"
+
 class MainLoop {
 public:
+    // Captures a trace from start-up for `seconds` and writes it to `path`
+    void setStartupTrace(const std::string& path, double seconds) {
+        tracePath = path;
+        traceSeconds = seconds;
+    }
+
     void run();
+
+    // Any thread: draw a frame even if nothing the loop tracks changed, e.g. after new
+    // data arrived while rendering on demand
+    void requestRedraw() { redraw.requestRedraw(); }
+
+private:
+    RedrawScheduler redraw;
+    std::string tracePath;
+    double traceSeconds = 0.0;
 };
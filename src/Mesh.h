@@ -0,0 +1,65 @@
+// Mesh.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include "GpuAllocator.h"
+#include "HelpStructures.h"
+
+// One level of detail: an index range into the mesh's shared buffers
+struct MeshLod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;  // object-space distance from the true surface, 0 for the finest level
+};
+
+constexpr uint32_t MaxMeshLods = 8;
+constexpr uint32_t NoLod = ~0u;
+// A coarser level than the current one must beat the threshold by this fraction, so an
+// object sitting right at a switch distance does not flicker between levels
+constexpr float LodHysteresis = 0.15f;
+
+// Vertex + index buffers of one uploaded mesh
+struct GpuMesh {
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    GpuAllocation vertexAllocation;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    GpuAllocation indexAllocation;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    float boundingRadius = 1.0f; // object-space bounding sphere around the origin
+    uint64_t uploadTicket = 0;   // UploadManager ticket covering both buffers
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    float positionScale = 1.0f;  // Packed: decoded snorm positions are multiplied by this
+    // Coarsest first. A plain mesh has a single level covering every index.
+    MeshLod lods[MaxMeshLods];
+    uint32_t lodCount = 0;
+
+    bool valid() const { return vertexBuffer != VK_NULL_HANDLE && indexBuffer != VK_NULL_HANDLE; }
+};
+
+// Index element type -> VkIndexType; only the two widths core Vulkan guarantees
+template <typename IndexT> constexpr VkIndexType indexTypeOf();
+template <> constexpr VkIndexType indexTypeOf<uint16_t>() { return VK_INDEX_TYPE_UINT16; }
+template <> constexpr VkIndexType indexTypeOf<uint32_t>() { return VK_INDEX_TYPE_UINT32; }
+
+// Distance from which `lod` keeps its error under `pixelError` on screen. pixelsPerUnit is
+// the projected size of one unit at distance 1 (projection [1][1] times half the viewport height).
+inline float lodSwitchDistance(const MeshLod& lod, float pixelsPerUnit, float pixelError) {
+    return lod.error * pixelsPerUnit / pixelError;
+}
+
+// Coarsest level that stays under pixelError at `distance` (in mesh units), with
+// LodHysteresis applied against `previous` (NoLod if none). cull_instances.comp mirrors this.
+inline uint32_t selectMeshLod(const GpuMesh& mesh, float distance, float pixelsPerUnit, float pixelError,
+                              uint32_t previous) {
+    for (uint32_t level = 0; level + 1 < mesh.lodCount; ++level) {
+        float switchDistance = lodSwitchDistance(mesh.lods[level], pixelsPerUnit, pixelError);
+        if (previous != NoLod && level < previous)
+            switchDistance *= 1.0f + LodHysteresis;
+        if (distance >= switchDistance)
+            return level;
+    }
+    return mesh.lodCount > 0 ? mesh.lodCount - 1 : 0;
+}
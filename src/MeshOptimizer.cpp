@@ -0,0 +1,162 @@
+// MeshOptimizer.cpp
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+// === Vertex cache ordering (Tipsify) ===
+//
+// Walks the mesh fanning around one vertex at a time: all of its remaining triangles are
+// emitted, then the next fanning vertex is picked among the vertices just touched, favouring
+// the one that is still in the cache and has the fewest triangles left. When none of them
+// qualifies, the walk resumes from the most recently used vertex with work left (the
+// dead-end stack), or from the next vertex in input order.
+template <typename IndexT>
+void MeshOptimizer::optimizeVertexCache(std::vector<IndexT>& indices, uint32_t vertexCount,
+                                        uint32_t cacheSize) {
+    if (indices.size() % 3 != 0)
+        throw std::runtime_error("Index count is not a multiple of 3");
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // Vertex -> triangle adjacency in compressed rows
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (IndexT index : indices) {
+        if (index >= vertexCount)
+            throw std::runtime_error("Index out of range");
+        liveTriangles[index]++;
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<IndexT> output;
+    output.reserve(indices.size());
+    deadEnd.reserve(indices.size());
+
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 1;
+    int64_t fanning = 0;
+
+    while (fanning >= 0) {
+        candidates.clear();
+        uint32_t f = static_cast<uint32_t>(fanning);
+        for (uint32_t a = adjacencyOffset[f]; a < adjacencyOffset[f + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                output.push_back(static_cast<IndexT>(v));
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+        }
+
+        // Next fanning vertex: the candidate that stays in the cache longest after
+        // emitting its remaining triangles
+        fanning = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0)
+                continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = time - cacheTime[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        if (fanning < 0) {
+            while (!deadEnd.empty() && fanning < 0) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0)
+                    fanning = v;
+            }
+            while (fanning < 0 && cursor < vertexCount) {
+                if (liveTriangles[cursor] > 0)
+                    fanning = cursor;
+                ++cursor;
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+// === Vertex fetch ordering ===
+template <typename IndexT>
+void MeshOptimizer::buildFetchRemap(const std::vector<IndexT>& indices, uint32_t vertexCount,
+                                    std::vector<uint32_t>& remap) {
+    const uint32_t Unassigned = ~0u;
+    remap.assign(vertexCount, Unassigned);
+    uint32_t next = 0;
+    for (IndexT index : indices) {
+        if (remap[index] == Unassigned)
+            remap[index] = next++;
+    }
+    for (auto& slot : remap) {
+        if (slot == Unassigned)
+            slot = next++;
+    }
+}
+
+// === Statistics ===
+template <typename IndexT>
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<IndexT>& indices, uint32_t vertexCount,
+                                                   uint32_t cacheSize) {
+    VertexCacheStats stats;
+    if (indices.size() < 3 || vertexCount == 0)
+        return stats;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since its own
+    std::vector<uint32_t> cachedAt(vertexCount, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t misses = 0;
+    uint32_t uniqueVertices = 0;
+    for (IndexT index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = 1;
+            uniqueVertices++;
+        }
+        if (cachedAt[index] == 0 || misses - cachedAt[index] >= cacheSize) {
+            misses++;
+            cachedAt[index] = misses;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+    return stats;
+}
+
+double MeshOptimizer::nowMs() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// === Index type instantiations ===
+template void MeshOptimizer::optimizeVertexCache<uint16_t>(std::vector<uint16_t>&, uint32_t, uint32_t);
+template void MeshOptimizer::optimizeVertexCache<uint32_t>(std::vector<uint32_t>&, uint32_t, uint32_t);
+template void MeshOptimizer::buildFetchRemap<uint16_t>(const std::vector<uint16_t>&, uint32_t, std::vector<uint32_t>&);
+template void MeshOptimizer::buildFetchRemap<uint32_t>(const std::vector<uint32_t>&, uint32_t, std::vector<uint32_t>&);
+template VertexCacheStats MeshOptimizer::analyzeVertexCache<uint16_t>(const std::vector<uint16_t>&, uint32_t, uint32_t);
+template VertexCacheStats MeshOptimizer::analyzeVertexCache<uint32_t>(const std::vector<uint32_t>&, uint32_t, uint32_t);
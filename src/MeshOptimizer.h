@@ -0,0 +1,84 @@
+// MeshOptimizer.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Post-transform vertex cache statistics of an index buffer, from a FIFO cache simulation
+struct VertexCacheStats {
+    float acmr = 0.0f;  // average cache miss ratio: transformed vertices per triangle (0.5 ideal, 3 worst)
+    float atvr = 0.0f;  // average transformed vertex ratio: transformed / referenced vertices (1 ideal)
+};
+
+struct MeshOptimizerStats {
+    VertexCacheStats before;
+    VertexCacheStats after;  // equals `before` when the mesh was not optimized
+    bool optimized = false;
+    double ms = 0.0;         // optimization time, excluding the statistics
+    // Per level of an LOD chain, in MeshLod order; empty for single-level meshes
+    std::vector<VertexCacheStats> lodBefore;
+    std::vector<VertexCacheStats> lodAfter;
+};
+
+// Index and vertex reordering for any indexed triangle list with uint16_t or uint32_t
+// indices; nothing here is specific to the sphere generators. Optimizing changes neither
+// the triangles nor their winding, only the order they are drawn in and where their
+// vertices live.
+//
+// Overdraw ordering is not done: the meshes drawn today are convex, so front faces never
+// overlap and any triangle order has the same overdraw.
+class MeshOptimizer {
+public:
+    // Simulated cache size; small enough that the order also suits GPUs with tiny caches
+    static constexpr uint32_t DefaultCacheSize = 16;
+
+    // Reorders triangles for post-transform cache hits (Tipsify, Sander et al. 2007).
+    // Linear in the index count.
+    template <typename IndexT>
+    static void optimizeVertexCache(std::vector<IndexT>& indices, uint32_t vertexCount,
+                                    uint32_t cacheSize = DefaultCacheSize);
+
+    // Renumbers vertices in first-use order so vertex fetch walks the buffer forwards.
+    // Run after optimizeVertexCache. Unreferenced vertices are kept, after the others.
+    template <typename VertexT, typename IndexT>
+    static void optimizeVertexFetch(std::vector<VertexT>& vertices, std::vector<IndexT>& indices) {
+        std::vector<uint32_t> remap;
+        buildFetchRemap(indices, static_cast<uint32_t>(vertices.size()), remap);
+
+        std::vector<VertexT> reordered(vertices.size());
+        for (size_t v = 0; v < vertices.size(); ++v)
+            reordered[remap[v]] = vertices[v];
+        vertices.swap(reordered);
+        for (auto& index : indices)
+            index = static_cast<IndexT>(remap[index]);
+    }
+
+    template <typename IndexT>
+    static VertexCacheStats analyzeVertexCache(const std::vector<IndexT>& indices, uint32_t vertexCount,
+                                               uint32_t cacheSize = DefaultCacheSize);
+
+    // Both passes plus before/after statistics
+    template <typename VertexT, typename IndexT>
+    static MeshOptimizerStats optimize(std::vector<VertexT>& vertices, std::vector<IndexT>& indices) {
+        uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        MeshOptimizerStats stats;
+        stats.before = analyzeVertexCache(indices, vertexCount);
+
+        double start = nowMs();
+        optimizeVertexCache(indices, vertexCount);
+        optimizeVertexFetch(vertices, indices);
+        stats.ms = nowMs() - start;
+
+        stats.after = analyzeVertexCache(indices, vertexCount);
+        stats.optimized = true;
+        return stats;
+    }
+
+private:
+    // remap[old] = new
+    template <typename IndexT>
+    static void buildFetchRemap(const std::vector<IndexT>& indices, uint32_t vertexCount,
+                                std::vector<uint32_t>& remap);
+    static double nowMs();
+};
@@ -0,0 +1,242 @@
+// ParallelRecorder.cpp
+#include "ParallelRecorder.h"
+#include "Tracer.h"
+#include <stdexcept>
+#include <string>
+
+void ParallelRecorder::init(VkDevice inDevice, uint32_t inQueueFamilyIndex, uint32_t inFrameCount,
+                            uint32_t workerCount) {
+    device = inDevice;
+    queueFamilyIndex = inQueueFamilyIndex;
+    frameCount = inFrameCount;
+    caches.resize(frameCount);
+    setWorkerCount(workerCount);
+}
+
+void ParallelRecorder::cleanup() {
+    stopWorkers();
+    for (auto& threadPools : pools)
+        for (auto& slot : threadPools)
+            if (slot.pool != VK_NULL_HANDLE) vkDestroyCommandPool(device, slot.pool, nullptr);
+    pools.clear();
+    for (auto& frameCache : caches)
+        for (auto& entry : frameCache)
+            if (entry.pool != VK_NULL_HANDLE) vkDestroyCommandPool(device, entry.pool, nullptr);
+    caches.clear();
+}
+
+void ParallelRecorder::setWorkerCount(uint32_t count) {
+    stopWorkers();
+    ensurePools(count + 1);
+
+    running = true;
+    for (uint32_t i = 0; i < count; ++i)
+        workers.emplace_back(&ParallelRecorder::run, this, i + 1, jobGeneration);
+}
+
+void ParallelRecorder::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+        if (worker.joinable()) worker.join();
+    workers.clear();
+}
+
+void ParallelRecorder::ensurePools(uint32_t threadCount) {
+    // Pools of threads that went away are kept; they are reused if the count grows again
+    while (pools.size() < threadCount) {
+        std::vector<ThreadPool> threadPools(frameCount);
+        for (auto& slot : threadPools) {
+            VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            poolInfo.queueFamilyIndex = queueFamilyIndex;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &slot.pool) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create recording command pool");
+        }
+        pools.push_back(std::move(threadPools));
+    }
+}
+
+VkCommandBuffer ParallelRecorder::acquire(ThreadPool& slot) {
+    if (slot.used == slot.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        allocInfo.commandPool = slot.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &buffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate secondary command buffer");
+        slot.buffers.push_back(buffer);
+    }
+    return slot.buffers[slot.used++];
+}
+
+VkCommandBuffer ParallelRecorder::acquireCached(CachedTask& entry) {
+    if (entry.pool == VK_NULL_HANDLE) {
+        VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &entry.pool) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create cached command pool");
+
+        VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        allocInfo.commandPool = entry.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &entry.buffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate cached command buffer");
+    } else {
+        vkResetCommandPool(device, entry.pool, 0);
+    }
+    entry.version = 0;
+    return entry.buffer;
+}
+
+void ParallelRecorder::record(uint32_t frame, VkFormat colorFormat, VkFormat depthFormat, VkExtent2D extent,
+                              const std::vector<RenderTask>& tasks, std::vector<VkCommandBuffer>& out) {
+    out.assign(tasks.size(), VK_NULL_HANDLE);
+    if (tasks.empty())
+        return;
+
+    // The slot's fence has been waited on, so none of its buffers is still pending
+    for (auto& threadPools : pools) {
+        vkResetCommandPool(device, threadPools[frame].pool, 0);
+        threadPools[frame].used = 0;
+    }
+
+    job.frame = frame;
+    job.colorFormat = colorFormat;
+    job.rendering.colorAttachmentCount = 1;
+    job.rendering.pColorAttachmentFormats = &job.colorFormat;
+    job.rendering.depthAttachmentFormat = depthFormat;
+    job.rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    job.inheritance.pNext = &job.rendering;
+    job.extent = extent;
+    job.tasks = &tasks;
+    job.out = &out;
+
+    // Cached tasks whose version still matches are executed as they are
+    std::vector<CachedTask>& cache = caches[frame];
+    if (cache.size() < tasks.size())
+        cache.resize(tasks.size());
+    job.versions.assign(tasks.size(), 0);
+    job.reused.assign(tasks.size(), 0);
+    reused = 0;
+    for (uint32_t i = 0; i < tasks.size(); ++i) {
+        if (!tasks[i].cacheVersion)
+            continue;
+        uint64_t version = tasks[i].cacheVersion();
+        const CachedTask& entry = cache[i];
+        if (version != 0 && entry.version == version && entry.name == tasks[i].name) {
+            out[i] = entry.buffer;
+            job.reused[i] = 1;
+            reused++;
+        }
+        job.versions[i] = version;
+    }
+    nextTask.store(0, std::memory_order_relaxed);
+    error = nullptr;
+
+    if (!workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = static_cast<uint32_t>(workers.size());
+            jobGeneration++;
+        }
+        wake.notify_all();
+    }
+
+    // Main-thread tasks first, while the workers start on the rest; then help with those
+    for (uint32_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i].mainThread && !job.reused[i])
+            recordTask(0, i);
+    }
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending == 0; });
+    job.tasks = nullptr;
+    job.out = nullptr;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ParallelRecorder::run(uint32_t threadIndex, uint64_t seenGeneration) {
+    std::string name = "Record worker " + std::to_string(threadIndex);
+    Tracer::get().setThreadName(name.c_str());
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return !running || jobGeneration != seenGeneration; });
+            if (!running)
+                return;
+            seenGeneration = jobGeneration;
+        }
+
+        drain(threadIndex);
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --pending == 0;
+        }
+        if (last)
+            finished.notify_one();
+    }
+}
+
+void ParallelRecorder::drain(uint32_t threadIndex) {
+    const std::vector<RenderTask>& tasks = *job.tasks;
+    for (;;) {
+        uint32_t i = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (i >= tasks.size())
+            return;
+        if (!tasks[i].mainThread && !job.reused[i])
+            recordTask(threadIndex, i);
+    }
+}
+
+void ParallelRecorder::recordTask(uint32_t threadIndex, uint32_t taskIndex) {
+    const RenderTask& task = (*job.tasks)[taskIndex];
+    uint64_t version = job.versions[taskIndex];
+    CachedTask* entry = version != 0 ? &caches[job.frame][taskIndex] : nullptr;
+    try {
+        VkCommandBuffer cmd = entry ? acquireCached(*entry) : acquire(pools[threadIndex][job.frame]);
+
+        // A cached buffer is executed again in later frames, into whichever image is acquired
+        VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        if (!entry)
+            beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &job.inheritance;
+        if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
+            throw std::runtime_error("Failed to begin secondary command buffer");
+
+        // Dynamic state is not inherited from the primary
+        VkViewport viewport{ 0.0f, 0.0f, (float)job.extent.width, (float)job.extent.height, 0.0f, 1.0f };
+        VkRect2D scissor{ {0, 0}, job.extent };
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+        {
+            TraceScope trace(task.name, "record");
+            if (task.record)
+                task.record(cmd);
+        }
+
+        if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+            throw std::runtime_error("Failed to record secondary command buffer");
+        (*job.out)[taskIndex] = cmd;
+        if (entry) {
+            entry->version = version;
+            entry->name = task.name;
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+            error = std::current_exception();
+    }
+}
@@ -0,0 +1,121 @@
+// ParallelRecorder.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One unit of work inside the main render pass: a pass or a batch of draws recorded into its
+// own secondary command buffer. The buffer arrives begun, with viewport and scissor set.
+// `name` must outlive the frame; it labels the task in trace captures.
+struct RenderTask {
+    const char* name = "";
+    std::function<void(VkCommandBuffer)> record;
+    // Record on the calling thread, for code that is not thread-safe (e.g. ImGui)
+    bool mainThread = false;
+    // Optional, for content that rarely changes. Returns a version of everything the
+    // recording depends on: pipelines, buffers, descriptor sets, draw counts, the attachment
+    // formats and extent. While it stays the same, the buffer recorded for this task (by position in
+    // the list) in the same frame slot is executed again instead of being re-recorded.
+    // 0 records as usual. Called on the calling thread before any task is recorded.
+    std::function<uint64_t()> cacheVersion;
+};
+
+// Records RenderTasks into secondary command buffers on a small worker pool.
+//
+// Every thread, the caller included, has its own command pool per frame slot, so recording
+// takes no lock on Vulkan objects; a slot's pools are reset as a whole once its fence has
+// been waited on. Tasks are handed out in order through an atomic cursor and the caller
+// records alongside the workers. The returned buffers are in task order, ready for
+// vkCmdExecuteCommands, whatever thread recorded them.
+//
+// Buffers inherit a dynamic rendering pass (vkCmdBeginRendering), which names attachment
+// formats but no images. Cached tasks (RenderTask::cacheVersion) keep a command pool and
+// buffer of their own per frame slot, recorded without ONE_TIME_SUBMIT, and are valid for
+// every swapchain image.
+//
+// Tasks on worker threads may only read shared state; anything they write must be private
+// to the task.
+class ParallelRecorder {
+public:
+    void init(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t workerCount);
+    void cleanup();
+
+    // Joins the current workers and starts `count` new ones; 0 records everything on the
+    // calling thread. Call between frames.
+    void setWorkerCount(uint32_t count);
+    uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+    // Call after `frame`'s fence has been waited on: the slot's previous buffers are recycled.
+    // Rethrows the first exception thrown by a task.
+    // The pass must be begun with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT and
+    // one color and one depth attachment of the given formats.
+    void record(uint32_t frame, VkFormat colorFormat, VkFormat depthFormat, VkExtent2D extent,
+                const std::vector<RenderTask>& tasks, std::vector<VkCommandBuffer>& out);
+    // Cached buffers the last record() executed again instead of recording
+    uint32_t getReusedCount() const { return reused; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t queueFamilyIndex = 0;
+    uint32_t frameCount = 0;
+
+    // Per thread (0 = calling thread) and frame slot
+    struct ThreadPool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;  // allocated so far, reused after each reset
+        uint32_t used = 0;
+    };
+    std::vector<std::vector<ThreadPool>> pools;  // [thread][frame]
+
+    // Per frame slot and task position; only the thread recording the task touches it
+    struct CachedTask {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        uint64_t version = 0;      // 0: nothing valid recorded
+        const char* name = nullptr;
+    };
+    std::vector<std::vector<CachedTask>> caches;  // [frame][task]
+    uint32_t reused = 0;
+    void ensurePools(uint32_t threadCount);
+    VkCommandBuffer acquire(ThreadPool& pool);
+
+    // The job being recorded; valid while `pending` is non-zero
+    struct Job {
+        uint32_t frame = 0;
+        VkCommandBufferInheritanceInfo inheritance{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+        VkCommandBufferInheritanceRenderingInfo rendering{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        const std::vector<RenderTask>* tasks = nullptr;
+        std::vector<VkCommandBuffer>* out = nullptr;
+        std::vector<uint64_t> versions;  // per task: cache version to record under, 0 if transient
+        std::vector<uint8_t> reused;     // per task: cached buffer still valid, nothing to record
+    };
+    Job job;
+    std::atomic<uint32_t> nextTask{ 0 };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;      // workers: a new job or shutdown
+    std::condition_variable finished;  // caller: every worker is done with the job
+    uint64_t jobGeneration = 0;
+    uint32_t pending = 0;              // workers still on the current job
+    bool running = false;
+    std::exception_ptr error;
+
+    // `seenGeneration` is the job generation at start-up, so a job published before the
+    // thread first takes the lock is not missed
+    void run(uint32_t threadIndex, uint64_t seenGeneration);
+    // Records tasks from the shared cursor until none are left
+    void drain(uint32_t threadIndex);
+    void recordTask(uint32_t threadIndex, uint32_t taskIndex);
+    VkCommandBuffer acquireCached(CachedTask& entry);
+    void stopWorkers();
+};
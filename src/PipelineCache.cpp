@@ -0,0 +1,111 @@
+// PipelineCache.cpp
+#include "PipelineCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Layout of VkPipelineCacheHeaderVersionOne
+constexpr size_t HeaderSize = 16 + VK_UUID_SIZE;
+
+uint32_t readU32(const std::vector<char>& data, size_t offset) {
+    uint32_t value;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+}
+
+void PipelineCache::init(VkDevice inDevice, VkPhysicalDevice physicalDevice, const std::string& inPath) {
+    device = inDevice;
+    path = inPath;
+    loadedBytes = 0;
+    rejectReason.clear();
+
+    std::vector<char> data;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (file.is_open()) {
+        std::streamoff size = file.tellg();
+        if (size > 0) {
+            data.resize(static_cast<size_t>(size));
+            file.seekg(0);
+            file.read(data.data(), size);
+            if (!file)
+                data.clear();
+        }
+    }
+
+    if (!data.empty()) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+        if (data.size() < HeaderSize || readU32(data, 0) < HeaderSize || readU32(data, 0) > data.size())
+            rejectReason = "truncated header";
+        else if (readU32(data, 4) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+            rejectReason = "unknown header version";
+        else if (readU32(data, 8) != props.vendorID || readU32(data, 12) != props.deviceID)
+            rejectReason = "different GPU";
+        else if (memcmp(data.data() + 16, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+            rejectReason = "different driver";
+
+        if (!rejectReason.empty())
+            data.clear();
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+        // The driver may still refuse data that passed the header check; start empty
+        rejectReason = "rejected by driver";
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create pipeline cache");
+        data.clear();
+    }
+    loadedBytes = data.size();
+}
+
+void PipelineCache::save() {
+    if (cache == VK_NULL_HANDLE || path.empty())
+        return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    // Failing to persist the cache only costs startup time next run, so report and go on
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(size));
+        file.flush();
+        if (!file) {
+            fprintf(stderr, "[pipeline cache] Failed to write %s\n", tempPath.c_str());
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        fprintf(stderr, "[pipeline cache] Failed to replace %s: %s\n", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+void PipelineCache::cleanup() {
+    if (cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+}
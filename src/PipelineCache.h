@@ -0,0 +1,31 @@
+// PipelineCache.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+
+// VkPipelineCache persisted between runs.
+//
+// init() seeds the cache from disk when the file's header matches this device and driver
+// (vendor ID, device ID and pipelineCacheUUID); anything else is discarded and the cache
+// starts empty. save() writes to a temporary file and renames it over the old one, so a
+// crash mid-write never leaves a truncated cache behind.
+class PipelineCache {
+public:
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+    void save();
+    void cleanup();
+
+    VkPipelineCache get() const { return cache; }
+    bool isWarm() const { return loadedBytes > 0; }
+    size_t getLoadedBytes() const { return loadedBytes; }
+    // Why the file on disk was not used; empty when it was loaded or did not exist
+    const std::string& getRejectReason() const { return rejectReason; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string path;
+    size_t loadedBytes = 0;
+    std::string rejectReason;
+};
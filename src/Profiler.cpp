@@ -0,0 +1,151 @@
+// Profiler.cpp
+#include "Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+const char* phaseName(CpuPhase phase) {
+    switch (phase) {
+    case CpuPhase::PollEvents: return "Poll events";
+    case CpuPhase::Geometry: return "Geometry";
+    case CpuPhase::Record: return "Record";
+    case CpuPhase::Submit: return "Submit";
+    case CpuPhase::Present: return "Present";
+    default: return "?";
+    }
+}
+
+const char* phaseName(GpuPhase phase) {
+    switch (phase) {
+    case GpuPhase::Culling: return "Culling";
+    case GpuPhase::SpherePass: return "Sphere pass";
+    case GpuPhase::ImGuiPass: return "ImGui pass";
+    default: return "?";
+    }
+}
+
+TimestampProperties getTimestampProperties(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueProps(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueProps.data());
+
+    TimestampProperties timestamps;
+    uint32_t validBits = queueProps[queueFamilyIndex].timestampValidBits;
+    if (validBits == 0 || props.limits.timestampPeriod == 0.0f)
+        return timestamps;
+    timestamps.mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    timestamps.periodNs = props.limits.timestampPeriod;
+    return timestamps;
+}
+
+#if DV_PROFILER
+
+void Profiler::init(VkDevice inDevice, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t frameCount) {
+    device = inDevice;
+    slots.assign(frameCount, SlotQueries{});
+    for (float& ms : history[head].gpuMs) ms = -1.0f;
+
+    timestamps = getTimestampProperties(physicalDevice, queueFamilyIndex);
+    if (!timestamps.supported())
+        return;  // CPU phases only
+
+    VkQueryPoolCreateInfo queryInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = frameCount * GpuPhaseCount * 2;
+    if (vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create profiler query pool");
+}
+
+void Profiler::cleanup() {
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void Profiler::endFrame() {
+    completed++;
+    head = (head + 1) % HistorySize;
+    history[head] = ProfileSample{};
+    history[head].frame = completed;
+    for (float& ms : history[head].gpuMs) ms = -1.0f;
+}
+
+void Profiler::collectGpu(uint32_t frame) {
+    SlotQueries& slot = slots[frame];
+    if (queryPool == VK_NULL_HANDLE || !slot.reset)
+        return;
+
+    // The sample may already have been recycled if the ring is shorter than the latency
+    ProfileSample& sample = history[slot.historyIndex];
+    if (sample.frame == slot.frame) {
+        struct Result { uint64_t value, available; };
+        Result results[GpuPhaseCount * 2];
+        vkGetQueryPoolResults(device, queryPool, queryIndex(frame, GpuPhase(0)), GpuPhaseCount * 2,
+                              sizeof(results), results, sizeof(Result),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        bool valid[GpuPhaseCount] = {};
+        uint64_t first = ~0ull;
+        uint64_t last = 0;
+        for (uint32_t p = 0; p < GpuPhaseCount; ++p) {
+            const Result& begin = results[p * 2];
+            const Result& end = results[p * 2 + 1];
+            valid[p] = begin.available && end.available;
+            if (!valid[p])
+                continue;
+            sample.gpuMs[p] = static_cast<float>(((end.value - begin.value) & timestamps.mask) * timestamps.periodNs * 1e-6);
+            first = std::min(first, begin.value);
+            last = std::max(last, end.value);
+        }
+        if (first != ~0ull)
+            sample.gpuScopesMs = static_cast<float>(((last - first) & timestamps.mask) * timestamps.periodNs * 1e-6);
+
+        Tracer& tracer = Tracer::get();
+        if (tracer.isCapturing() && slot.recordStartNs != 0 && first != ~0ull) {
+            // Same queue, so this frame cannot have started before the previous one ended
+            uint64_t base = std::max(slot.recordStartNs, lastGpuEndNs);
+            auto toCpu = [&](uint64_t ticks) {
+                return base + static_cast<uint64_t>(((ticks - first) & timestamps.mask) * timestamps.periodNs);
+            };
+            for (uint32_t p = 0; p < GpuPhaseCount; ++p) {
+                if (!valid[p])
+                    continue;
+                uint64_t end = toCpu(results[p * 2 + 1].value);
+                tracer.completeGpu(phaseName(static_cast<GpuPhase>(p)), toCpu(results[p * 2].value), end);
+                lastGpuEndNs = std::max(lastGpuEndNs, end);
+            }
+        }
+    }
+    slot.reset = false;
+}
+
+void Profiler::resetGpu(VkCommandBuffer cmd, uint32_t frame) {
+    recordingSlot = frame;
+    SlotQueries& slot = slots[frame];
+    slot.frame = history[head].frame;
+    slot.historyIndex = head;
+    slot.reset = true;
+    slot.recordStartNs = Tracer::get().isCapturing() ? Tracer::nowNs() : 0;
+    if (queryPool != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(cmd, queryPool, queryIndex(frame, GpuPhase(0)), GpuPhaseCount * 2);
+}
+
+void Profiler::beginGpu(VkCommandBuffer cmd, GpuPhase phase) {
+    if (queryPool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, queryIndex(recordingSlot, phase));
+}
+
+void Profiler::endGpu(VkCommandBuffer cmd, GpuPhase phase) {
+    if (queryPool == VK_NULL_HANDLE)
+        return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, queryIndex(recordingSlot, phase) + 1);
+}
+
+const ProfileSample& Profiler::getSample(uint32_t index) const {
+    uint32_t count = getSampleCount();
+    return history[(head + HistorySize - count + index) % HistorySize];
+}
+
+#endif
@@ -0,0 +1,180 @@
+// Profiler.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Tracer.h"
+
+// Build with -DDV_PROFILER=0 (CMake: -DDV_ENABLE_PROFILER=OFF) to compile every timer and
+// timestamp query out; the API below stays, as empty inline functions.
+#ifndef DV_PROFILER
+#define DV_PROFILER 1
+#endif
+
+enum class CpuPhase : uint32_t { PollEvents, Geometry, Record, Submit, Present, Count };
+enum class GpuPhase : uint32_t { Culling, SpherePass, ImGuiPass, Count };
+
+constexpr uint32_t CpuPhaseCount = static_cast<uint32_t>(CpuPhase::Count);
+constexpr uint32_t GpuPhaseCount = static_cast<uint32_t>(GpuPhase::Count);
+
+const char* phaseName(CpuPhase phase);
+const char* phaseName(GpuPhase phase);
+
+// Timestamp support of one queue family. Shared by the profiler's per-phase queries and
+// GraphicsModule's whole-frame pair, which stays when the profiler is compiled out.
+struct TimestampProperties {
+    double periodNs = 0.0;  // 0 when the queue cannot write timestamps
+    uint64_t mask = ~0ull;  // timestampValidBits; apply to tick differences so a wrap stays small
+    bool supported() const { return periodNs != 0.0; }
+};
+TimestampProperties getTimestampProperties(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+// Timings of one frame. GPU values are negative until the frame's queries have been read
+// back, which happens when its frame slot comes around again.
+struct ProfileSample {
+    uint64_t frame = 0;
+    float cpuMs[CpuPhaseCount] = {};
+    float gpuMs[GpuPhaseCount] = {};
+    // First to last profiled GPU scope, -1 until read back. Not the whole command buffer:
+    // that is FrameStats::gpuFrameMs
+    float gpuScopesMs = -1.0f;
+};
+
+#if DV_PROFILER
+
+// Per-frame CPU phase timers and GPU timestamp ranges, kept in a fixed ring of samples.
+//
+// CPU time is accumulated into the current sample by CpuScope. GPU ranges are written by
+// GpuScope into a per-frame-slot query range, reset at the start of the slot's command
+// buffer and read back without waiting once the slot's fence has signalled. The cost is
+// two clock reads per CPU scope and two timestamps per GPU scope.
+//
+// While a trace is being captured, both kinds also go to the Tracer. GPU ranges are placed
+// on the CPU timeline at the later of the frame's recording start and the end of the
+// previous GPU frame; durations and offsets within a frame are exact.
+class Profiler {
+public:
+    static constexpr bool Enabled = true;
+    static constexpr uint32_t HistorySize = 256;
+
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t frameCount);
+    void cleanup();
+
+    // Closes the current sample and starts the next one; called at the end of every frame
+    void endFrame();
+    void addCpuTime(CpuPhase phase, double ms) { history[head].cpuMs[static_cast<uint32_t>(phase)] += static_cast<float>(ms); }
+
+    // Render thread, per frame slot
+    void collectGpu(uint32_t frame);                      // after the slot's fence wait
+    void resetGpu(VkCommandBuffer cmd, uint32_t frame);   // outside a render pass, before any GpuScope
+    // Any recording thread, including into secondary command buffers that are executed
+    // again in later frames: results are read by availability, not by what was recorded
+    void beginGpu(VkCommandBuffer cmd, GpuPhase phase);
+    void endGpu(VkCommandBuffer cmd, GpuPhase phase);
+
+    // Completed samples, oldest first; the frame being recorded is not included
+    uint32_t getSampleCount() const { return completed < HistorySize - 1 ? completed : HistorySize - 1; }
+    const ProfileSample& getSample(uint32_t index) const;
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    TimestampProperties timestamps;
+
+    std::vector<ProfileSample> history = std::vector<ProfileSample>(HistorySize);
+    uint32_t head = 0;               // sample being recorded
+    uint64_t completed = 0;
+
+    struct SlotQueries {
+        uint64_t frame = 0;          // sample the queries belong to
+        uint32_t historyIndex = 0;
+        bool reset = false;          // queries reset by the slot's last frame; phases it did not
+                                     // write stay unavailable and are skipped
+        uint64_t recordStartNs = 0;  // CPU time the slot's commands were recorded, for tracing
+    };
+    uint64_t lastGpuEndNs = 0;
+    std::vector<SlotQueries> slots;
+    uint32_t recordingSlot = 0;
+
+    uint32_t queryIndex(uint32_t slot, GpuPhase phase) const {
+        return (slot * GpuPhaseCount + static_cast<uint32_t>(phase)) * 2;
+    }
+};
+
+#else
+
+class Profiler {
+public:
+    static constexpr bool Enabled = false;
+    static constexpr uint32_t HistorySize = 0;
+
+    void init(VkDevice, VkPhysicalDevice, uint32_t, uint32_t) {}
+    void cleanup() {}
+    void endFrame() {}
+    void addCpuTime(CpuPhase, double) {}
+    void collectGpu(uint32_t) {}
+    void resetGpu(VkCommandBuffer, uint32_t) {}
+    void beginGpu(VkCommandBuffer, GpuPhase) {}
+    void endGpu(VkCommandBuffer, GpuPhase) {}
+    uint32_t getSampleCount() const { return 0; }
+    const ProfileSample& getSample(uint32_t) const { static ProfileSample empty; return empty; }
+};
+
+#endif
+
+// Adds the time spent in the enclosing block to `phase` of the current sample
+class CpuScope {
+public:
+#if DV_PROFILER
+    CpuScope(Profiler& profiler, CpuPhase phase)
+        : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~CpuScope() { stop(); }
+    // Ends the scope early, for phases that do not map onto a block
+    void stop() {
+        if (stopped)
+            return;
+        stopped = true;
+        auto end = std::chrono::steady_clock::now();
+        profiler.addCpuTime(phase, std::chrono::duration<double, std::milli>(end - start).count());
+        // Phases also show up in a trace capture
+        Tracer& tracer = Tracer::get();
+        if (tracer.isCapturing())
+            tracer.complete(phaseName(phase), "frame", toNs(start), toNs(end));
+    }
+#else
+    CpuScope(Profiler&, CpuPhase) {}
+    void stop() {}
+#endif
+    CpuScope(const CpuScope&) = delete;
+    CpuScope& operator=(const CpuScope&) = delete;
+
+#if DV_PROFILER
+private:
+    Profiler& profiler;
+    CpuPhase phase;
+    std::chrono::steady_clock::time_point start;
+    bool stopped = false;
+
+    static uint64_t toNs(std::chrono::steady_clock::time_point time) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()).count());
+    }
+#endif
+};
+
+// Brackets the commands recorded in the enclosing block with a pair of timestamps
+class GpuScope {
+public:
+    GpuScope(Profiler& profiler, VkCommandBuffer cmd, GpuPhase phase)
+        : profiler(profiler), cmd(cmd), phase(phase) { profiler.beginGpu(cmd, phase); }
+    ~GpuScope() { profiler.endGpu(cmd, phase); }
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    Profiler& profiler;
+    VkCommandBuffer cmd;
+    GpuPhase phase;
+};
@@ -0,0 +1,58 @@
+// RedrawScheduler.cpp
+#include "RedrawScheduler.h"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstring>
+
+void RedrawScheduler::setOnDemand(bool enabled) {
+    if (enabled != onDemand)
+        dirty = true;
+    onDemand = enabled;
+}
+
+void RedrawScheduler::requestRedraw() {
+    forced.store(true, std::memory_order_release);
+
+    SDL_Event event;
+    std::memset(&event, 0, sizeof(event));
+    event.type = SDL_EVENT_USER;
+    SDL_PushEvent(&event);
+}
+
+RedrawScheduler::Clock::duration RedrawScheduler::idleInterval() const {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxIdleFps));
+}
+
+int32_t RedrawScheduler::waitTimeoutMs(Clock::time_point now) const {
+    if (!onDemand || dirty || forced.load(std::memory_order_acquire) || now < settleUntil)
+        return 0;
+    if (!animating || maxIdleFps <= 0.0f)
+        return -1;
+
+    auto remaining = lastFrame + idleInterval() - now;
+    if (remaining <= Clock::duration::zero())
+        return 0;
+    // Rounded up, so the wait does not end just short of the frame being due
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(remaining + std::chrono::milliseconds(1) -
+                                                                   Clock::duration(1)).count();
+    return static_cast<int32_t>(std::min<int64_t>(ms, INT32_MAX));
+}
+
+void RedrawScheduler::onInput(Clock::time_point now) {
+    dirty = true;
+    settleUntil = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(InputSettleSeconds));
+}
+
+bool RedrawScheduler::shouldDraw(Clock::time_point now) {
+    bool wasForced = forced.exchange(false, std::memory_order_acq_rel);
+    bool draw = !onDemand || dirty || wasForced || now < settleUntil ||
+                (animating && maxIdleFps > 0.0f && now >= lastFrame + idleInterval());
+    if (!draw)
+        skippedFrames++;
+    return draw;
+}
+
+void RedrawScheduler::onFrameDrawn(Clock::time_point now) {
+    dirty = false;
+    lastFrame = now;
+}
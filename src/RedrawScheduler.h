@@ -0,0 +1,56 @@
+// RedrawScheduler.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Decides whether the main loop draws a frame and how long it may sleep waiting for events.
+//
+// Continuous mode draws every iteration. On demand, a frame is drawn when the scene was
+// marked dirty (input, a camera or geometry change, requestRedraw()); with nothing pending
+// the loop blocks in SDL_WaitEvent and neither the CPU nor the GPU does any work. Things
+// that change the picture without input (an animating fleet, a geometry build in flight,
+// an active ImGui widget) count as animating and are drawn at most at the idle frame rate
+// cap. Input also opens a short settle window at full rate, which lets ImGui finish the
+// hover delays and fades it started.
+class RedrawScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double InputSettleSeconds = 0.5;
+
+    void setOnDemand(bool enabled);
+    bool isOnDemand() const { return onDemand; }
+    // Frame rate cap while only animations are pending; 0 draws them only on input
+    void setMaxIdleFps(float fps) { maxIdleFps = fps > 0.0f ? fps : 0.0f; }
+    float getMaxIdleFps() const { return maxIdleFps; }
+
+    // Any thread: draw a frame soon, e.g. after new telemetry arrived. Wakes a blocked
+    // event wait through an SDL user event.
+    void requestRedraw();
+
+    // === Main loop ===
+    // Milliseconds the event wait may block: 0 polls, -1 waits for the next event
+    int32_t waitTimeoutMs(Clock::time_point now) const;
+    void onInput(Clock::time_point now);
+    void markDirty() { dirty = true; }
+    void setAnimating(bool value) { animating = value; }
+    bool shouldDraw(Clock::time_point now);
+    void onFrameDrawn(Clock::time_point now);
+
+    // Loop iterations that woke up without drawing
+    uint64_t getSkippedFrames() const { return skippedFrames; }
+
+private:
+    bool onDemand = true;
+    float maxIdleFps = 30.0f;
+    bool dirty = true;                 // the first frame is always drawn
+    bool animating = false;
+    std::atomic<bool> forced{ false };
+    Clock::time_point settleUntil{};
+    Clock::time_point lastFrame{};
+    uint64_t skippedFrames = 0;
+
+    Clock::duration idleInterval() const;
+};
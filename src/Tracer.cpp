@@ -0,0 +1,145 @@
+// Tracer.cpp
+#include "Tracer.h"
+#include <chrono>
+#include <cstdio>
+
+Tracer& Tracer::get() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::~Tracer() {
+    shutdown();
+}
+
+uint64_t Tracer::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->tid = static_cast<uint32_t>(buffers.size()) + GpuTrack;  // tids after the GPU track
+        buffer->name = "Thread " + std::to_string(buffer->tid);
+    }
+    return *buffer;
+}
+
+void Tracer::setThreadName(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer.name = name;
+}
+
+void Tracer::record(const char* name, const char* category, uint64_t startNs, uint64_t endNs, uint32_t track) {
+    ThreadBuffer& buffer = threadBuffer();
+
+    // First event of a new capture on this thread: the writer is done with the old events
+    uint64_t current = generation.load(std::memory_order_acquire);
+    if (buffer.generation.load(std::memory_order_relaxed) != current) {
+        buffer.generation.store(current, std::memory_order_relaxed);
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= EventsPerThread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[index] = Event{ name, category, startNs, endNs, track };
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::start() {
+    if (isCapturing() || isWriting())
+        return false;
+    if (writer.joinable())
+        writer.join();
+
+    captureStartNs = nowNs();
+    generation.fetch_add(1, std::memory_order_release);
+    capturing.store(true, std::memory_order_release);
+    fprintf(stderr, "[trace] capture started\n");
+    return true;
+}
+
+void Tracer::stop() {
+    if (!capturing.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    std::vector<ThreadBuffer*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers)
+            snapshot.push_back(buffer.get());
+    }
+
+    writing.store(true, std::memory_order_release);
+    writer = std::thread(&Tracer::write, this, std::move(snapshot),
+                         generation.load(std::memory_order_acquire), captureStartNs, outputPath);
+}
+
+void Tracer::shutdown() {
+    stop();
+    if (writer.joinable())
+        writer.join();
+}
+
+void Tracer::write(std::vector<ThreadBuffer*> snapshot, uint64_t captureGeneration, uint64_t startNs, std::string path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "[trace] Failed to open %s\n", path.c_str());
+        writing.store(false, std::memory_order_release);
+        return;
+    }
+
+    // Timestamps in microseconds relative to the start of the capture
+    auto us = [&](uint64_t ns) { return ns > startNs ? (ns - startNs) / 1000.0 : 0.0; };
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"DroneVisualizer\"}},\n");
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU graphics queue\"}}",
+            GpuTrack);
+
+    size_t written = 0, dropped = 0;
+    for (ThreadBuffer* buffer : snapshot) {
+        // Threads that recorded nothing in this capture still hold an older generation.
+        // The count is published after the generation, so load it first.
+        uint32_t count = buffer->count.load(std::memory_order_acquire);
+        if (buffer->generation.load(std::memory_order_relaxed) != captureGeneration)
+            continue;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            name = buffer->name;
+        }
+        fprintf(file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                buffer->tid, name.c_str());
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const Event& event = buffer->events[i];
+            uint32_t tid = event.track == GpuTrack ? GpuTrack : buffer->tid;
+            fprintf(file, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, event.category, tid, us(event.startNs),
+                    event.endNs > event.startNs ? (event.endNs - event.startNs) / 1000.0 : 0.0);
+        }
+        written += count;
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    if (ok)
+        fprintf(stderr, "[trace] wrote %zu events to %s%s\n", written, path.c_str(),
+                dropped ? " (some events dropped: per-thread buffer full)" : "");
+    else
+        fprintf(stderr, "[trace] Failed to write %s\n", path.c_str());
+    writing.store(false, std::memory_order_release);
+}
@@ -0,0 +1,99 @@
+// Tracer.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Captures timeline events and writes them as a Chrome trace-event JSON file
+// (chrome://tracing, https://ui.perfetto.dev).
+//
+// Each thread records into its own fixed-size buffer: the owning thread is the only writer
+// and publishes each event with a release store of the count, so recording takes no lock.
+// stop() hands the buffers to a writer thread, which formats and writes the file while the
+// render thread carries on; a new capture cannot start until that write has finished.
+class Tracer {
+public:
+    static Tracer& get();
+
+    // Names the calling thread's track in the trace
+    void setThreadName(const char* name);
+
+    bool start();                            // false while a previous capture is being written
+    void stop();                             // writes to the output path in the background
+    void toggle() { if (isCapturing()) stop(); else start(); }
+    void setOutputPath(const std::string& path) { outputPath = path; }
+    bool isCapturing() const { return capturing.load(std::memory_order_relaxed); }
+    bool isWriting() const { return writing.load(std::memory_order_acquire); }
+    void shutdown();                         // stops a capture in progress and joins the writer
+
+    static uint64_t nowNs();
+
+    // A finished span on the calling thread's track. `name` and `category` must be string
+    // literals or otherwise outlive the capture.
+    void complete(const char* name, const char* category, uint64_t startNs, uint64_t endNs) {
+        if (isCapturing()) record(name, category, startNs, endNs, ThreadTrack);
+    }
+    // A span on the GPU queue track, with times already mapped onto the CPU clock
+    void completeGpu(const char* name, uint64_t startNs, uint64_t endNs) {
+        if (isCapturing()) record(name, "gpu", startNs, endNs, GpuTrack);
+    }
+
+    ~Tracer();
+
+private:
+    static constexpr uint32_t EventsPerThread = 1u << 16;
+    static constexpr uint32_t ThreadTrack = 0;
+    static constexpr uint32_t GpuTrack = 1;
+
+    struct Event {
+        const char* name;
+        const char* category;
+        uint64_t startNs;
+        uint64_t endNs;
+        uint32_t track;
+    };
+    struct ThreadBuffer {
+        uint32_t tid = 0;
+        std::string name;
+        std::atomic<uint64_t> generation{ 0 };  // capture the events belong to; written by the owner
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint32_t> dropped{ 0 };
+        std::unique_ptr<Event[]> events{ new Event[EventsPerThread] };
+    };
+
+    std::atomic<bool> capturing{ false };
+    std::atomic<bool> writing{ false };
+    std::atomic<uint64_t> generation{ 0 };
+    uint64_t captureStartNs = 0;
+    std::string outputPath = "trace.json";
+
+    std::mutex buffersMutex;             // guards registration only
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::thread writer;
+
+    ThreadBuffer& threadBuffer();
+    void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs, uint32_t track);
+    void write(std::vector<ThreadBuffer*> snapshot, uint64_t captureGeneration, uint64_t startNs, std::string path);
+};
+
+// Records the enclosing block as a span on the calling thread's track
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* category = "cpu")
+        : name(name), category(category), start(Tracer::get().isCapturing() ? Tracer::nowNs() : 0) {}
+    ~TraceScope() {
+        if (start != 0) Tracer::get().complete(name, category, start, Tracer::nowNs());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    uint64_t start;
+};
@@ -0,0 +1,304 @@
+// UploadManager.cpp
+#include "UploadManager.h"
+#include "VulkanHelperMethods.h"
+#include <stdexcept>
+#include <cstring>
+
+namespace {
+// Satisfies optimalBufferCopyOffsetAlignment on every known implementation
+constexpr VkDeviceSize StagingAlignment = 16;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+void UploadManager::init(VkDevice inDevice, GpuAllocator& inAllocator,
+                         uint32_t inGraphicsFamily, VkQueue inGraphicsQueue,
+                         uint32_t inTransferFamily, VkQueue inTransferQueue,
+                         VkDeviceSize stagingSize) {
+    device = inDevice;
+    allocator = &inAllocator;
+    graphicsFamily = inGraphicsFamily;
+    graphicsQueue = inGraphicsQueue;
+    transferFamily = inTransferFamily;
+    transferQueue = inTransferQueue;
+
+    VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    poolInfo.queueFamilyIndex = transferFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload command pool");
+
+    VkSemaphoreTypeCreateInfo timelineInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    semaphoreInfo.pNext = &timelineInfo;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload timeline semaphore");
+
+    ringSize = stagingSize;
+    createBuffer(device, *allocator, ringSize,
+                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 stagingBuffer, stagingAllocation);
+    stagingMapped = static_cast<uint8_t*>(stagingAllocation.mapped);
+}
+
+void UploadManager::cleanup() {
+    // Caller is expected to have idled the device
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& batch : inFlight)
+        releaseBatch(batch);
+    inFlight.clear();
+    releaseBatch(pendingBatch);
+    pendingCopies.clear();
+    pendingAcquires.clear();
+
+    if (stagingBuffer != VK_NULL_HANDLE) {
+        destroyBuffer(device, *allocator, stagingBuffer, stagingAllocation);
+        stagingMapped = nullptr;
+    }
+    if (timeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device, timeline, nullptr);
+        timeline = VK_NULL_HANDLE;
+    }
+    if (commandPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device, commandPool, nullptr);
+        commandPool = VK_NULL_HANDLE;
+    }
+    freeCommandBuffers.clear();
+}
+
+uint64_t UploadManager::enqueueBufferUpload(VkBuffer dst, VkDeviceSize dstOffset,
+                                            const void* data, VkDeviceSize size,
+                                            VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    PendingCopy copy{};
+    copy.dst = dst;
+    copy.dstOffset = dstOffset;
+    copy.size = size;
+    copy.dstStage = dstStage;
+    copy.dstAccess = dstAccess;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VkDeviceSize offset = 0;
+    if (size <= ringSize && allocateStaging(size, offset)) {
+        memcpy(stagingMapped + offset, data, static_cast<size_t>(size));
+        copy.src = stagingBuffer;
+        copy.srcOffset = offset;
+    } else {
+        // Larger than the ring, or the ring is still held by in-flight batches: give the copy
+        // a one-off staging buffer owned by the batch rather than stalling the caller
+        TempStaging temp{};
+        createBuffer(device, *allocator, size,
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     temp.buffer, temp.allocation);
+        memcpy(temp.allocation.mapped, data, static_cast<size_t>(size));
+
+        pendingBatch.tempStaging.push_back(temp);
+        copy.src = temp.buffer;
+        copy.srcOffset = 0;
+    }
+
+    pendingCopies.push_back(copy);
+    return lastSubmittedValue + 1;
+}
+
+bool UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize& offset) {
+    reclaimCompleted();
+
+    if (ringUsed == 0) {
+        ringHead = 0;
+        ringTail = 0;
+    }
+
+    VkDeviceSize aligned = alignUp(ringHead, StagingAlignment);
+    VkDeviceSize consumed = 0;
+
+    if (ringHead > ringTail || ringUsed == 0) {
+        // Free space is [head, end) followed by [0, tail)
+        if (aligned + size <= ringSize) {
+            offset = aligned;
+            consumed = aligned - ringHead + size;
+        } else if (size <= ringTail) {
+            offset = 0;
+            consumed = ringSize - ringHead + size;
+        } else {
+            return false;
+        }
+    } else if (ringHead < ringTail) {
+        // Wrapped: free space is [head, tail)
+        if (aligned + size > ringTail)
+            return false;
+        offset = aligned;
+        consumed = aligned - ringHead + size;
+    } else {
+        return false; // head == tail with data in flight: ring is full
+    }
+
+    ringHead = offset + size;
+    ringUsed += consumed;
+    pendingBatch.ringBytes += consumed;
+    pendingBatch.ringHead = ringHead;
+    return true;
+}
+
+void UploadManager::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingCopies.empty())
+        return;
+
+    reclaimCompleted();
+
+    VkCommandBuffer cmd;
+    if (!freeCommandBuffers.empty()) {
+        cmd = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &cmd) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate upload command buffer");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &beginInfo);
+
+    std::vector<VkBufferMemoryBarrier2> releases;
+    for (const auto& copy : pendingCopies) {
+        VkBufferCopy region{ copy.srcOffset, copy.dstOffset, copy.size };
+        vkCmdCopyBuffer(cmd, copy.src, copy.dst, 1, &region);
+
+        if (hasDedicatedTransferQueue()) {
+            // Release half of the queue-family ownership transfer; the graphics queue acquires
+            VkBufferMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+            barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+            barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            barrier.dstAccessMask = VK_ACCESS_2_NONE;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.buffer = copy.dst;
+            barrier.offset = copy.dstOffset;
+            barrier.size = copy.size;
+            releases.push_back(barrier);
+
+            // Source stage matches the semaphore wait stage so the acquire is ordered after
+            // the release. Legacy stage and access bits keep their values in the 2 variants.
+            VkBufferMemoryBarrier2 acquire = barrier;
+            acquire.srcStageMask = copy.dstStage;
+            acquire.srcAccessMask = VK_ACCESS_2_NONE;
+            acquire.dstStageMask = copy.dstStage;
+            acquire.dstAccessMask = copy.dstAccess;
+            pendingAcquires.push_back(acquire);
+        }
+        graphicsWaitStages |= copy.dstStage;
+    }
+
+    if (!releases.empty()) {
+        VkDependencyInfo dependency{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(releases.size());
+        dependency.pBufferMemoryBarriers = releases.data();
+        vkCmdPipelineBarrier2(cmd, &dependency);
+    }
+
+    vkEndCommandBuffer(cmd);
+
+    uint64_t signalValue = lastSubmittedValue + 1;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline;
+
+    if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit upload batch");
+
+    lastSubmittedValue = signalValue;
+    graphicsWaitValue = signalValue;
+
+    pendingBatch.cmd = cmd;
+    pendingBatch.timelineValue = signalValue;
+    inFlight.push_back(std::move(pendingBatch));
+    pendingBatch = Batch{};
+    pendingBatch.ringHead = ringHead;
+    pendingCopies.clear();
+}
+
+void UploadManager::recordAcquireBarriers(VkCommandBuffer cmd) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingAcquires.empty())
+        return;
+
+    VkDependencyInfo dependency{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(pendingAcquires.size());
+    dependency.pBufferMemoryBarriers = pendingAcquires.data();
+    vkCmdPipelineBarrier2(cmd, &dependency);
+    pendingAcquires.clear();
+}
+
+bool UploadManager::takeGraphicsWait(VkSemaphore& semaphore, uint64_t& value, VkPipelineStageFlags& stages) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (graphicsWaitStages == 0)
+        return false;
+
+    semaphore = timeline;
+    value = graphicsWaitValue;
+    stages = graphicsWaitStages;
+    graphicsWaitStages = 0;
+    return true;
+}
+
+bool UploadManager::isComplete(uint64_t ticket) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ticket > lastSubmittedValue)
+            return false;
+    }
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &completed);
+    return completed >= ticket;
+}
+
+void UploadManager::reclaimCompleted() {
+    if (inFlight.empty())
+        return;
+
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &completed);
+
+    // Batches retire in submission order on a single queue
+    while (!inFlight.empty() && inFlight.front().timelineValue <= completed) {
+        Batch& batch = inFlight.front();
+        if (batch.ringBytes > 0) {
+            ringUsed -= batch.ringBytes;
+            ringTail = batch.ringHead;
+        }
+        releaseBatch(batch);
+        inFlight.pop_front();
+    }
+}
+
+void UploadManager::releaseBatch(Batch& batch) {
+    for (auto& temp : batch.tempStaging)
+        destroyBuffer(device, *allocator, temp.buffer, temp.allocation);
+    batch.tempStaging.clear();
+
+    if (batch.cmd != VK_NULL_HANDLE) {
+        vkResetCommandBuffer(batch.cmd, 0);
+        freeCommandBuffers.push_back(batch.cmd);
+        batch.cmd = VK_NULL_HANDLE;
+    }
+}
@@ -0,0 +1,108 @@
+// UploadManager.h
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include "GpuAllocator.h"
+
+// Streams buffer data to DEVICE_LOCAL memory through a persistently mapped staging ring.
+//
+// Uploads enqueued during a frame are recorded into one command buffer and submitted by
+// flush() on the transfer queue (a dedicated transfer-only family when the device has one).
+// Completion is tracked with a timeline semaphore: the graphics submit of the same frame
+// waits on it, and staging space is reclaimed once the GPU has passed a batch's value.
+//
+// enqueueBufferUpload() may be called from any thread and never submits or blocks on the
+// GPU; flush() and the graphics-side calls belong to the render thread, which owns the queues.
+class UploadManager {
+public:
+    void init(VkDevice device, GpuAllocator& allocator,
+              uint32_t graphicsFamily, VkQueue graphicsQueue,
+              uint32_t transferFamily, VkQueue transferQueue,
+              VkDeviceSize stagingSize = 16ull * 1024 * 1024);
+    void cleanup();
+
+    // Copies `size` bytes into staging memory and schedules a copy into dst.
+    // dstStage/dstAccess describe the first graphics-queue use of the data.
+    // Returns a ticket that can be passed to isComplete().
+    uint64_t enqueueBufferUpload(VkBuffer dst, VkDeviceSize dstOffset,
+                                 const void* data, VkDeviceSize size,
+                                 VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    // Submits everything enqueued since the last flush as one batch. Call once per frame.
+    void flush();
+
+    // Records the queue-family acquire barriers for batches flushed since the last call.
+    // Must be recorded outside a render pass, in the next graphics submit.
+    void recordAcquireBarriers(VkCommandBuffer cmd);
+
+    // Timeline wait the next graphics submit must include; false if there is nothing to wait on.
+    bool takeGraphicsWait(VkSemaphore& semaphore, uint64_t& value, VkPipelineStageFlags& stages);
+
+    bool isComplete(uint64_t ticket) const;
+    bool hasDedicatedTransferQueue() const { return graphicsFamily != transferFamily; }
+
+private:
+    struct PendingCopy {
+        VkBuffer src;
+        VkDeviceSize srcOffset;
+        VkBuffer dst;
+        VkDeviceSize dstOffset;
+        VkDeviceSize size;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags dstAccess;
+    };
+
+    struct TempStaging {
+        VkBuffer buffer;
+        GpuAllocation allocation;
+    };
+
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint64_t timelineValue = 0;
+        VkDeviceSize ringBytes = 0;   // staging bytes (including alignment/wrap padding) held by the batch
+        VkDeviceSize ringHead = 0;    // ring head after the batch's last allocation
+        std::vector<TempStaging> tempStaging; // uploads larger than the ring
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    uint32_t graphicsFamily = 0;
+    uint32_t transferFamily = 0;
+    VkQueue graphicsQueue = VK_NULL_HANDLE;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    uint64_t lastSubmittedValue = 0;
+
+    // Staging ring
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    GpuAllocation stagingAllocation;
+    uint8_t* stagingMapped = nullptr;
+    VkDeviceSize ringSize = 0;
+    VkDeviceSize ringHead = 0;
+    VkDeviceSize ringTail = 0;
+    VkDeviceSize ringUsed = 0;
+
+    // Current (not yet flushed) batch
+    std::vector<PendingCopy> pendingCopies;
+    Batch pendingBatch;
+
+    std::deque<Batch> inFlight;
+
+    // Acquire side, consumed by the graphics queue
+    std::vector<VkBufferMemoryBarrier2> pendingAcquires;
+    uint64_t graphicsWaitValue = 0;
+    VkPipelineStageFlags graphicsWaitStages = 0;
+
+    mutable std::mutex mutex;
+
+    bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+    void reclaimCompleted();
+    void releaseBatch(Batch& batch);
+};
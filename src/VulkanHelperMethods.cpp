@@ -1,11 +1,13 @@
 // VulkanHelperMethods.cpp
 #include "VulkanHelperMethods.h"
 #include <stdexcept>
+#include <fstream>
+#include <vector>
 
-void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
+void createBuffer(VkDevice device, GpuAllocator& allocator,
                   VkDeviceSize size, VkBufferUsageFlags usage,
                   VkMemoryPropertyFlags properties,
-                  VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+                  VkBuffer& buffer, GpuAllocation& allocation) {
     VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     bufferInfo.size = size;
     bufferInfo.usage = usage;
@@ -18,29 +20,119 @@ void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memRequirements.size;
+    try {
+        allocation = allocator.allocate(memRequirements, properties);
+    } catch (...) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        throw;
+    }
+
+    if (vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        destroyBuffer(device, allocator, buffer, allocation);
+        throw std::runtime_error("Failed to bind buffer memory");
+    }
+}
+
+void destroyBuffer(VkDevice device, GpuAllocator& allocator,
+                   VkBuffer& buffer, GpuAllocation& allocation) {
+    if (buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+    }
+    allocator.free(allocation);
+}
+
+void createImage(VkDevice device, GpuAllocator& allocator,
+                 uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+                 VkImage& image, GpuAllocation& allocation) {
+    VkImageCreateInfo imageInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { width, height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image");
+    }
 
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-    bool memTypeFound = false;
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            allocInfo.memoryTypeIndex = i;
-            memTypeFound = true;
-            break;
-        }
+    try {
+        allocation = allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    } catch (...) {
+        vkDestroyImage(device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        throw;
     }
 
-    if (!memTypeFound) {
-        throw std::runtime_error("Failed to find suitable memory type for buffer");
+    if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        destroyImage(device, allocator, image, allocation);
+        throw std::runtime_error("Failed to bind image memory");
     }
+}
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate buffer memory");
+void destroyImage(VkDevice device, GpuAllocator& allocator,
+                  VkImage& image, GpuAllocation& allocation) {
+    if (image != VK_NULL_HANDLE) {
+        vkDestroyImage(device, image, nullptr);
+        image = VK_NULL_HANDLE;
     }
+    allocator.free(allocation);
+}
+
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect) {
+    VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = aspect;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image view");
+    }
+    return view;
+}
+
+void memoryBarrier(VkCommandBuffer cmd, const VkMemoryBarrier2& barrier) {
+    VkDependencyInfo dependency{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dependency.memoryBarrierCount = 1;
+    dependency.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+VkShaderModule loadShaderModule(VkDevice device, const std::string& fileName) {
+    std::string path = std::string(SHADER_PATH) + fileName;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open file: " + path);
+
+    size_t size = (size_t)file.tellg();
+    if (size == static_cast<size_t>(-1))
+        throw std::runtime_error("Failed to get file size: " + path);
+
+    std::vector<char> code(size);
+    file.seekg(0);
+    file.read(code.data(), size);
+
+    VkShaderModuleCreateInfo createInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    createInfo.codeSize = code.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    VkShaderModule module;
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create shader module: " + path);
+    return module;
 }
@@ -1,10 +1,29 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <string>
+#include "GpuAllocator.h"
 
-void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
+void createBuffer(VkDevice device, GpuAllocator& allocator,
                   VkDeviceSize size, VkBufferUsageFlags usage,
                   VkMemoryPropertyFlags properties,
-                  VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+                  VkBuffer& buffer, GpuAllocation& allocation);
 
+void destroyBuffer(VkDevice device, GpuAllocator& allocator,
+                   VkBuffer& buffer, GpuAllocation& allocation);
 
+// 2D, single mip, optimally tiled, DEVICE_LOCAL
+void createImage(VkDevice device, GpuAllocator& allocator,
+                 uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+                 VkImage& image, GpuAllocation& allocation);
+
+void destroyImage(VkDevice device, GpuAllocator& allocator,
+                  VkImage& image, GpuAllocation& allocation);
+
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect);
+
+// One global synchronization2 barrier
+void memoryBarrier(VkCommandBuffer cmd, const VkMemoryBarrier2& barrier);
+
+// Loads a compiled SPIR-V file from SHADER_PATH
+VkShaderModule loadShaderModule(VkDevice device, const std::string& fileName);
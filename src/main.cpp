@@ -1,8 +1,51 @@
 #include "MainLoop.h"
+#include "HeadlessBenchmark.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char* argv[]) {
 
+    // --headless [options]: render a fixed benchmark workload offscreen and print a JSON report
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        BenchmarkConfig config;
+        std::string error;
+        if (!HeadlessBenchmark::parseArguments(argc - 2, argv + 2, config, error)) {
+            std::fprintf(stderr, "%s\n%s", error.c_str(), HeadlessBenchmark::usage());
+            return 1;
+        }
+        HeadlessBenchmark benchmark;
+        return benchmark.run(config);
+    }
+
+    // --trace FILE [--trace-seconds S]: capture a trace from start-up (default 5 s, at most an hour)
+    const char* usage = "Usage: DroneVisualizer [--trace FILE [--trace-seconds S]]\n"
+                        "       DroneVisualizer --headless [options]\n";
+    const double maxTraceSeconds = 3600.0;
     MainLoop loop;
+    std::string tracePath;
+    double traceSeconds = 5.0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace-seconds") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            char* end = nullptr;
+            traceSeconds = std::strtod(value, &end);
+            if (end == value || *end != '\0' || !std::isfinite(traceSeconds) || traceSeconds <= 0.0 ||
+                traceSeconds > maxTraceSeconds) {
+                std::fprintf(stderr, "Invalid --trace-seconds: %s (expected more than 0, up to %.0f)\n%s",
+                             value, maxTraceSeconds, usage);
+                return 1;
+            }
+        } else {
+            std::fprintf(stderr, "Unknown option: %s\n%s", argv[i], usage);
+            return 1;
+        }
+    }
+    if (!tracePath.empty())
+        loop.setStartupTrace(tracePath, traceSeconds);
     loop.run();
 
     return 0;
@@ -0,0 +1,84 @@
+// GeometryCacheTest.cpp
+//
+// Cache bookkeeping only: meshes carry fake handles and nothing touches a device.
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "GeometryCache.h"
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+GeometryResult makeBuild(const GeometryRequest& request, uintptr_t handle) {
+    GeometryResult result;
+    result.request = request;
+    result.mesh.vertexBuffer = reinterpret_cast<VkBuffer>(handle);
+    result.mesh.indexBuffer = reinterpret_cast<VkBuffer>(handle + 1);
+    result.mesh.vertexAllocation.size = 1024;
+    result.mesh.indexAllocation.size = 512;
+    result.vertices.resize(16);
+    result.indices16.resize(48);
+    return result;
+}
+
+// Scrub K -> J -> K while the first K build is still in flight: the second K build must
+// not replace the pinned entry, whose mesh is the one on screen
+void duplicateKeyKeepsPinnedEntry() {
+    GeometryRequest k;
+    k.type = SphereType::Icosphere;
+    k.subdivisions = 3;
+    GeometryRequest j = k;
+    j.subdivisions = 4;
+
+    GeometryCache cache;
+    std::vector<GpuMesh> evicted;
+    cache.pin(k);
+    const GeometryResult* first = cache.insert(makeBuild(k, 0x100), evicted);
+    check(first != nullptr, "first build is cached");
+    check(evicted.empty(), "first build evicts nothing");
+    VkBuffer onScreen = first->mesh.vertexBuffer;
+
+    cache.insert(makeBuild(j, 0x200), evicted);
+    const GeometryResult* duplicate = cache.insert(makeBuild(k, 0x300), evicted);
+
+    check(duplicate == first, "duplicate insert returns the existing entry");
+    check(duplicate->mesh.vertexBuffer == onScreen, "pinned mesh stays cached");
+    check(evicted.size() == 1, "exactly one mesh handed back");
+    check(!evicted.empty() && evicted[0].vertexBuffer == reinterpret_cast<VkBuffer>(uintptr_t(0x300)),
+          "the new duplicate build is the one handed back");
+    check(cache.getStats().entries == 2, "two entries cached");
+
+    const GeometryResult* found = cache.find(k);
+    check(found != nullptr && found->mesh.vertexBuffer == onScreen, "lookup still finds the pinned mesh");
+
+    evicted.clear();
+    cache.clear(evicted);
+    check(evicted.size() == 2, "clear hands back both cached meshes");
+}
+
+// A LOD chain deeper than a mesh can hold would throw on the worker; normalize caps it
+void normalizeCapsLodChain() {
+    GeometryRequest request;
+    request.type = SphereType::IcosphereLod;
+    request.subdivisions = MaxMeshLods + 2;
+    check(GeometryCache::normalize(request).subdivisions == MaxMeshLods - 1, "LOD chain capped at MaxMeshLods levels");
+
+    request.subdivisions = 3;
+    check(GeometryCache::normalize(request).subdivisions == 3, "shallow LOD chain unchanged");
+}
+}
+
+int main() {
+    duplicateKeyKeepsPinnedEntry();
+    normalizeCapsLodChain();
+    if (failures == 0)
+        std::printf("GeometryCacheTest passed\n");
+    return failures == 0 ? 0 : 1;
+}